@@ -100,6 +100,10 @@
 	gcc -std=c11 warray.c -Wall -Wextra -Wpedantic wcollection.c myapp.c myapp
 	\endcode
 
+	warray_sortParallel() runs on a thread pool (WPool) of C11 threads, so add -pthread if your C
+	library needs it. wpool_new() creates pools with a chosen number of threads, optionally pinned
+	to processors. Parallel operations share the pool returned by wpool_default().
+
 
 	@section function_overview Function overview
 
@@ -170,6 +174,42 @@
 	WArray* array4 = warray_new( 0, &personType );
 	\endcode
 
+	If the elements are small fixed-size values or records, you can store them by value in one
+	contiguous block instead of allocating each one separately:
+
+	\code
+	typedef struct Point { double x, y; }Point;
+
+	WArray* points = warray_newInline( 0, sizeof( Point ), NULL );	//Point elements
+	WArray* numbers = warray_newInline( 0, sizeof( double ), wtypeDouble );	//double elements
+	warray_append( points, &(Point){ 1.0, 2.0 });
+	warray_append( numbers, &(double){ 3.141 });
+	\endcode
+
+	By default all memory comes from malloc(). If you'd like to use an arena, a pool or
+	another malloc() replacement, pass a WAllocator when creating the array. Element types
+	with cloneWith() and deleteWith() methods, like wtypeStr and wtypeDouble, then allocate their
+	elements with it too:
+
+	\code
+	static const WAllocator poolAllocator = {
+		.alloc = poolAlloc,
+		.realloc = poolRealloc,
+		.free = poolFree,
+		.context = &myPool
+	};
+
+	WArray* names = warray_newWithAllocator( 0, wtypeStr, &poolAllocator );
+	\endcode
+
+	If an array holds lots of strings which are created and dropped together, take the
+	wtypeStrArena type. Its strings are bump-allocated in an arena owned by the array, and
+	warray_clear() and warray_delete() release them all at once:
+
+	\code
+	WArray* lines = warray_new( 0, wtypeStrArena );
+	\endcode
+
 	Copying an array is simple: Just one function call and the array structure, capacity, size
 	and type information are copied. The elements are copied into the new array according to the type's
 	clone method:
@@ -188,6 +228,8 @@
 	\endcode
 
 	- warray_new()
+	- warray_newInline()
+	- warray_newWithAllocator()
 	- warray_clone()
 	- warray_delete()
 	- warray_clear()
@@ -235,10 +277,13 @@
 	- warray_set()
 	- warray_insert()
 	- warray_insertSorted()
+	- warray_insertSortedMany()
 	- warray_append_n()
 	- warray_prepend_n()
 	- warray_set_n()
 	- warray_insert_n()
+	- warray_pushInsert_n()
+	- warray_pushSet_n()
 	- warray_concat()
 
 
@@ -323,6 +368,14 @@
 	- warray_compact()
 	- warray_sort()
 	- warray_sortBy()
+	- warray_sortParallel()
+	- warray_sortStable()
+	- warray_sortStableBy()
+	- warray_sortByKey()
+	- warray_sortByKeys()
+	- warray_nthElement()
+	- warray_partialSort()
+	- warray_topK()
 	- warray_distinct()
 
 
@@ -397,6 +450,10 @@
 
 	With warray_map() you can transform a given array with a callback function to a new array
 	with the same size and warray_reduce() lets you create a single result value from an array.
+	warray_fold() does the same with an accumulator changed in place, e.g. a WStrBuf, instead of
+	allocating a new intermediate result for every element.
+	The parallel variants of filter, map and reduce spread expensive callbacks over all processors
+	and return the same results.
 
 	- warray_foreach()
 	- warray_foreachIndex()
@@ -406,6 +463,53 @@
 	- warray_unselect()
 	- warray_map()
 	- warray_reduce()
+	- warray_fold()
+	- warray_filterParallel()
+	- warray_rejectParallel()
+	- warray_mapParallel()
+	- warray_reduceParallel()
+
+	Chained calls of these functions build a full array at every step. A lazy query records
+	filter and map stages instead and runs them in one pass, when a terminal function asks for
+	the result:
+
+	\code
+	//Count the long animal names in upper case without any array in between.
+	size_t count = wquery_count( wquery_filter( wquery_map( warray_query( animals ), toUpper, NULL, wtypeStr ),
+		animalLongerThan, (void*)3 ));
+	\endcode
+
+	- warray_query()
+	- wquery_filter()
+	- wquery_reject()
+	- wquery_map()
+	- wquery_collect()
+	- wquery_reduce()
+	- wquery_fold()
+	- wquery_count()
+	- wquery_any()
+	- wquery_first()
+	- wquery_delete()
+
+	If you only need to know which elements meet some conditions, warray_filterIndices() returns
+	a selection, a bitmap of the matching positions, without copying any element. Selections are
+	combined in place with wselection_and(), wselection_or() and wselection_not(), narrowed
+	with warray_filterSelected(), and turned into elements with warray_gather() or
+	warray_foreachSelected() at the end.
+
+	- warray_filterIndices()
+	- warray_filterSelected()
+	- warray_gather()
+	- warray_foreachSelected()
+	- wselection_new()
+	- wselection_delete()
+	- wselection_set()
+	- wselection_contains()
+	- wselection_count()
+	- wselection_and()
+	- wselection_or()
+	- wselection_not()
+	- wselection_positions()
 
 
 	@subsection checking Checking properties of the array elements
@@ -451,12 +555,17 @@
 	- warray_rindex()
 	- warray_bsearch()
 	- warray_contains()
+	- warray_enableIndex()
+	- warray_disableIndex()
+	- warray_enablePrefixes()
+	- warray_disablePrefixes()
 
 
 	@subsection converting Converting an array to and from a string
 
 	- warray_toString()
 	- warray_fromString()
+	- warray_splitView()
 
 
 	@subsection misc Miscellaneous
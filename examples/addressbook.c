@@ -115,6 +115,19 @@ personToString( const Person* person ) {
 	);
 }
 
+//Optional: Append the person directly to the string buffer used by warray_toString().
+void
+personToStrBuf( const Person* person, WStrBuf* buf ) {
+	wstrbuf_printf( buf, "%s, %s, %s, %u, %u, %s",
+		person->firstName,
+		person->name,
+		person->street,
+		person->number,
+		person->zipCode,
+		person->city
+	);
+}
+
 Person*
 personFromString( const char* str ) {
 	assert( str );
@@ -150,7 +163,8 @@ WType typePerson = {
 	.clone = (WElementClone*)personClone,
 	.delete = (WElementDelete*)personDelete,
 	.toString = (WElementToString*)personToString,
-	.fromString = (WElementFromString*)personFromString
+	.fromString = (WElementFromString*)personFromString,
+	.toStrBuf = (WElementToStrBuf*)personToStrBuf
 };
 
 //---------------------------------------------------------------------------------
@@ -203,16 +217,19 @@ addressbookAdd( WArray* addressbook, const char* command )
 	autoWArray* tokens = a.fromString( command, ", ", wtypeStr );
 	assert( a.size( tokens ) == 7 );
 
-	Person person = {
-		.firstName	= (char*)a.at( tokens, 1 ),
-		.name		= (char*)a.at( tokens, 2 ),
-		.street		= (char*)a.at( tokens, 3 ),
+	//Steal the strings from the tokens instead of cloning them, starting with the last one,
+	//so the positions of the remaining tokens stay valid.
+	Person* person = __wxnew( Person,
 		.number		= atoi( a.at( tokens, 4 )),
 		.zipCode	= atoi( a.at( tokens, 5 )),
-		.city		= (char*)a.at( tokens, 6 ),
-	};
+	);
+	person->city		= a.stealAt( tokens, 6 );
+	person->street		= a.stealAt( tokens, 3 );
+	person->name		= a.stealAt( tokens, 2 );
+	person->firstName	= a.stealAt( tokens, 1 );
 
-	a.append( addressbook, &person );
+	//The addressbook takes the person over without another clone.
+	warray_pushLast( addressbook, person );
 }
 
 void
@@ -1,5 +1,6 @@
 /*	Test program converting a key-value ini file from stdin to a corresponding JSON file at stdout.
-	It demonstrates the use of the warray_fromString(), warray_map() and warray_reduce() functions.
+	It demonstrates the use of the warray_fromString() function and of a lazy query, which maps
+	the lines and folds them into a string buffer in one pass.
 
 	Compile e.g. with gcc -std=c11 ini2json.c warray.c wcollection.c -o ./ini2json
 	and test with cat test.ini | ./ini2json > test.json
@@ -8,7 +9,7 @@
 #include <assert.h>		//assert()
 #include <stdio.h>		//fread(), fprintf(), fclose()
 #include <stdlib.h>		//free(), exit()
-#include <string.h>		//strcpy(), strrchr()
+#include <string.h>		//strlen(), memcpy()
 
 //---------------------------------------------------------------------------------
 //	The necessary prototypes
@@ -67,24 +68,24 @@ line2keyValuePair( const void* element, const void* unused )
 	return warray_fromString( element, "=", wtypeStr );
 }
 
-/*	Append the key and value from an array to the intermediate json string.
-		intermediate=
+/*	Append the key and value from an array to the json string buffer, which grows in place.
+		json =
 		"{
-			"key1": "value1",
-		"
-	+	element = ["key2", "value2"]
+			"key1": "value1"
+		+ element = ["key2", "value2"]
 	==>	"{
 			"key1": "value1",
-			"key2": "value2",
-		"
-
-
+			"key2": "value2"
 */
-static void*
-appendKeyValuePairToJson( const void* element, const void* intermediate )
+static void
+appendKeyValuePairToJson( const void* element, void* json, const void* unused )
 {
+	(void)unused;
 	const WArray* pair = element;
-	return __wstr_printf( "%s\t\"%s\": \"%s\",\n", intermediate, warray_at( pair, 0 ), warray_at( pair, 1 ));
+	WStrBuf* buf = json;
+	if ( buf->size > strlen( "{\n" ))
+		wstrbuf_append( buf, ",\n" );
+	wstrbuf_printf( buf, "\t\"%s\": \"%s\"", (char*)warray_at( pair, 0 ), warray_size( pair ) > 1 ? (char*)warray_at( pair, 1 ) : "" );
 }
 
 /*	Convert a line-oriented ini string to a json string:
@@ -101,7 +102,9 @@ appendKeyValuePairToJson( const void* element, const void* intermediate )
 			...
 		}
 
-	by splitting the string in an array and using warray_map() and warray_reduce() calls.
+	by splitting the string in an array and running a map and fold query over it. The query
+	maps and folds one line after the other into a single string buffer, so neither an array of
+	all key-value pairs nor a new json string per line is built.
 */
 char*
 ini2json( const char ini[] )
@@ -111,10 +114,10 @@ ini2json( const char ini[] )
 	//Split the string at line ends and create an array of char* elements: ["key1=value1", "key2=value2",... ]
 	WArray* lines = warray_fromString( ini, "\n", wtypeStr );
 
-	//Map it to an array with elements like this: [[key1, value1], [key2, values], ...]
-	WArray* keyValuePairs = warray_map(	//Map
-		lines,							//the array with key-value string elements
-		line2keyValuePair,				//applying this map function to every array element
+	//Map the non-empty lines to key-value pairs like this: [key1, value1], [key2, values], ...
+	WQuery* keyValuePairs = wquery_map(	//Map
+		wquery_reject( warray_query( lines ), wtypeStr_conditionEmpty, NULL ),	//the non-empty lines
+		line2keyValuePair,				//applying this map function to every line
 		NULL,							//without additional data to the callback function
 		wtypeArray						//and the hint on the result type (a WArray of WArrays).
 	);
@@ -122,25 +125,22 @@ ini2json( const char ini[] )
 	/*"	{
 			"key1": "value1",
 			"key2": "value2",
-			...,
+			...
 		"
 	*/
-	char* json = warray_reduce(		//Reduce
-		keyValuePairs,				//the array with key-value pairs
+	WStrBuf* json = wstrbuf_new( 0 );
+	wstrbuf_append( json, "{\n" );
+	wquery_fold(					//Fold
+		keyValuePairs,				//the key-value pairs, each deleted after appending it
 		appendKeyValuePairToJson,	//applying this function to every key-value pair
-		"{\n",						//with this as start for the json string
-		wtypeStr					//and this hint about the intermediate and result type (char*).
+		json,						//into the string buffer started with the opening brace
+		NULL						//without additional data to the callback function.
 	);
-
-	//Now we only have to replace the last ",\n" with a "\n}" and we are done.
-	char* jsonEnd = strrchr( json, ',' );
-	if ( jsonEnd ) strcpy( jsonEnd, "\n}" );
-
 	warray_delete( &lines );
-	warray_delete( &keyValuePairs );
 
-	assert( json );
-	return json;
+	//Now we only have to close the json object and we are done.
+	wstrbuf_append( json, "\n}" );
+	return wstrbuf_steal( &json );
 }
 
 //---------------------------------------------------------------------------------
@@ -66,8 +66,9 @@ sort( const char text[] )
 
 	//Split the string at line ends and create an array of char* elements. Mark the lines array
 	//to be autodestroyed when leaving scope. We use the namespace variable "a" defined above.
-	//It is equivalent to writing warray_fromString( text, "\n", wtypeStr ).
-	autoWArray* lines = a.fromString( text, "\n", wtypeStr );
+	//It is equivalent to writing warray_splitView( text, "\n" ), which copies the text once
+	//and lets the elements point into it instead of allocating every line.
+	autoWArray* lines = a.splitView( text, "\n" );
 
 	//Sort it and convert it back to a string.
 	a.sort( lines );
@@ -287,6 +287,37 @@ Test_warray_insertSorted()
 	assert_strequal( a.at( array, 5 ), "zebra" );
 }
 void
+Test_warray_insertSortedMany()
+{
+	autoWArray* array = warray_new( 0, wtypeStr );
+
+	a.insertSortedMany( array, 3, (void*[]){ "lion", "dog", NULL });
+	warray_insertSortedMany( array, 4, (void*[]){ "zebra", "", "elephant", "dog" });
+	assert_equal( array->size, 7 );
+	assert_null( a.at( array, 0 ));
+	assert_strequal( a.at( array, 1 ), "" );
+	assert_strequal( a.at( array, 2 ), "dog" );
+	assert_strequal( a.at( array, 3 ), "dog" );
+	assert_strequal( a.at( array, 4 ), "elephant" );
+	assert_strequal( a.at( array, 5 ), "lion" );
+	assert_strequal( a.at( array, 6 ), "zebra" );
+
+	//Compare with sorting everything.
+	autoWArray* numbers = warray_new( 0, wtypeInt );
+	autoWArray* expected = warray_new( 0, wtypeInt );
+	void* batch[100];
+	for ( size_t round = 0; round < 20; round++ ) {
+		for ( size_t i = 0; i < 100; i++ )
+			batch[i] = (void*)((i * 7907 + round * 131) % 1000);
+		warray_insertSortedMany( numbers, 100, batch );
+		warray_append_n( expected, 100, batch );
+		warray_insertSorted( numbers, (void*)round );
+		warray_append( expected, (void*)round );
+	}
+	warray_sort( expected );
+	assert_true( warray_equal( numbers, expected ));
+}
+void
 Test_warray_set()
 {
 	autoWArray *array = a.new( 0, wtypeStr );
@@ -327,6 +358,61 @@ Test_warray_pushAt()
     warray_pushAt( array, 0, str1 );
 	assert_strequal( a.first( array ), "cat" );
 	assert_null( str1 );
+
+	char* str2 = strdup( "dog" );
+	warray_pushFirst( array, str2 );
+	char* str3 = strdup( "bird" );
+	warray_pushLast( array, str3 );
+	char* str4 = strdup( "fish" );
+	warray_pushAt( array, 1, str4 );
+	assert_equal( a.size( array ), 4 );
+	assert_strequal( a.at( array, 0 ), "dog" );
+	assert_strequal( a.at( array, 1 ), "fish" );
+	assert_strequal( a.at( array, 2 ), "cat" );
+	assert_strequal( a.at( array, 3 ), "bird" );
+	assert_null( str2 );
+	assert_null( str4 );
+}
+
+void
+Test_warray_pushInsert_n()
+{
+	autoWArray* array = a.new( 0, wtypeStr );
+
+	void* elements[] = { strdup( "cat" ), strdup( "dog" ), NULL };
+	a.pushInsert_n( array, 0, 3, elements );
+	assert_equal( a.size( array ), 3 );
+	assert_null( elements[0] );
+	assert_null( elements[1] );
+
+	void* more[] = { strdup( "bird" ) };
+	a.pushInsert_n( array, 1, 1, more );
+	assert_strequal( a.at( array, 0 ), "cat" );
+	assert_strequal( a.at( array, 1 ), "bird" );
+	assert_strequal( a.at( array, 2 ), "dog" );
+	assert_null( a.at( array, 3 ));
+
+	void* replacements[] = { strdup( "fish" ), strdup( "frog" ) };
+	a.pushSet_n( array, 3, 2, replacements );
+	assert_equal( a.size( array ), 5 );
+	assert_strequal( a.at( array, 3 ), "fish" );
+	assert_strequal( a.at( array, 4 ), "frog" );
+	assert_null( replacements[0] );
+
+	//Inline arrays copy the bytes and free the gifted elements.
+	autoWArray* inlined = warray_newInline( 0, sizeof( int ), NULL );
+	int* value = malloc( sizeof( int ));
+	*value = 42;
+	void* values[] = { value };
+	a.pushInsert_n( inlined, 0, 1, values );
+	assert_equal( *(int*)a.at( inlined, 0 ), 42 );
+
+	//Arena arrays clone the gifted elements into their arena.
+	autoWArray* arena = a.new( 0, wtypeStrArena );
+	char* str = strdup( "owl" );
+	warray_pushLast( arena, str );
+	assert_strequal( a.first( arena ), "owl" );
+	assert_null( str );
 }
 
 //--------------------------------------------------------------------------------
@@ -1009,6 +1095,170 @@ Test_warray_toStringFromString()
 	assert_strequal( warray_at( split4b, 2 ), " mouse" );
 	assert_equal( warray_size( split4b ), 3 );
 }
+void
+Test_warray_splitView()
+{
+	const char* text = "cat, dog, , (NULL), bird, ";
+	autoWArray* views = warray_splitView( text, ", " );
+	autoWArray* copies = warray_fromString( text, ", ", wtypeStr );
+	assert_equal( views->size, 5 );
+	assert_equal( copies->size, 5 );
+	for ( size_t i = 0; i < 5; i++ )
+		assert_equal( wtypeStr_compare( warray_at( views, i ), warray_at( copies, i )), 0 );
+	assert_strequal( warray_at( views, 2 ), "" );
+	assert_null( warray_at( views, 3 ));
+
+	//The elements behave like any other strings.
+	warray_set( views, 0, "lion" );
+	warray_removeAt( views, 1 );
+	autoChar* bird = warray_stealLast( views );
+	assert_strequal( bird, "bird" );
+	autoChar* joined = warray_toString( views, "|" );
+	assert_strequal( joined, "lion||(NULL)" );
+
+	autoWArray* lines = warray_splitView( "b\nc\na", "\n" );
+	warray_sort( lines );
+	autoChar* sorted = warray_toString( lines, "\n" );
+	assert_strequal( sorted, "a\nb\nc" );
+
+	autoWArray* empty = warray_splitView( "", "\n" );
+	assert_true( warray_empty( empty ));
+}
+void
+Test_warray_toStringLarge()
+{
+	autoWArray* numbers = warray_new( 0, wtypeInt );
+	for ( size_t i = 0; i < 100000; i++ )
+		warray_append( numbers, (void*)(i % 9 + 1) );
+	warray_append( numbers, (void*)-42 );
+
+	autoChar* joined = warray_toString( numbers, "," );
+	assert_equal( strlen( joined ), 200000 + 3 );
+	assert_true( strncmp( joined, "1,2,3,4", 7 ) == 0 );
+	assert_strequal( joined + 199996, "9,1,-42" );
+
+	//Types with only a toString() method.
+	WType stringOnly = *wtypeStr;
+	stringOnly.toStrBuf = NULL;
+	autoWArray* strings = warray_new( 0, &stringOnly );
+	warray_append_n( strings, 3, (void*[]){ "cat", NULL, "dog" });
+	autoChar* joined2 = warray_toString( strings, " - " );
+	assert_strequal( joined2, "cat - (NULL) - dog" );
+
+	autoWArray* doubles = warray_newInline( 0, sizeof( double ), wtypeDouble );
+	warray_append_n( doubles, 2, (void*[]){ &(double){ 1.5 }, &(double){ -2 }});
+	autoChar* joined3 = warray_toString( doubles, "; " );
+	assert_strequal( joined3, "1.500000; -2.000000" );
+}
+void
+Test_warena()
+{
+	WArena* arena = warena_new( NULL );
+	const WAllocator* allocator = warena_allocator( arena );
+
+	//Growing the last allocation in place to an odd size keeps the next one aligned.
+	char* text = wallocator_alloc( allocator, 3 );
+	strcpy( text, "ab" );
+	char* grown = wallocator_realloc( allocator, text, 3, 13 );
+	assert_true( grown == text );
+	assert_strequal( grown, "ab" );
+	double* number = wallocator_alloc( allocator, sizeof( double ));
+	assert_equal( (uintptr_t)number % _Alignof( max_align_t ), 0 );
+	assert_true( (char*)number >= grown + 13 );
+
+	//Shrinking in place as well.
+	char* last = wallocator_alloc( allocator, 32 );
+	assert_true( wallocator_realloc( allocator, last, 32, 7 ) == last );
+	assert_equal( (uintptr_t)warena_alloc( arena, 1 ) % _Alignof( max_align_t ), 0 );
+
+	warena_delete( &arena );
+	assert_null( arena );
+}
+void
+Test_wstrbuf()
+{
+	WStrBuf* buf = wstrbuf_new( 4 );
+	assert_strequal( buf->string, "" );
+
+	wstrbuf_append( buf, "Hello" );
+	wstrbuf_appendn( buf, ", world!!!", 7 );
+	assert_strequal( buf->string, "Hello, world" );
+	assert_equal( buf->size, 12 );
+
+	for ( int i = 0; i < 1000; i++ )
+		wstrbuf_printf( buf, " %d", i );
+	assert_equal( buf->size, 12 + 1000 + 10 + 90*2 + 900*3 );
+	assert_strequal( buf->string + buf->size - 4, " 999" );
+
+	wstrbuf_clear( buf );
+	wstrbuf_printf( buf, "%s=%d", "answer", 42 );
+	assert_strequal( buf->string, "answer=42" );
+
+	char* string = wstrbuf_steal( &buf );
+	assert_null( buf );
+	assert_strequal( string, "answer=42" );
+	free( string );
+
+	wstrbuf_delete( &buf );
+}
+
+typedef struct PoolTestTask {
+	WPool* pool;
+	size_t number;
+	size_t result;
+	size_t parts[8];
+}PoolTestTask;
+
+static void
+squareTask( void* data )
+{
+	size_t* value = data;
+	*value *= *value;
+}
+
+//Sum the squares of number*8 up to number*8+7 in nested tasks.
+static void
+nestedTask( void* data )
+{
+	PoolTestTask* task = data;
+	for ( size_t i = 0; i < 8; i++ )
+		task->parts[i] = task->number*8 + i;
+	wpool_run( task->pool, squareTask, task->parts, 8, sizeof( size_t ));
+	for ( size_t i = 0; i < 8; i++ )
+		task->result += task->parts[i];
+}
+
+void
+Test_wpool()
+{
+	size_t threads[] = { 1, 2, 4, 0 };
+	for ( size_t t = 0; t < 4; t++ ) {
+		WPool* pool = wpool_new( threads[t], t == 2 );
+		assert_equal( wpool_threads( pool ), threads[t] ? threads[t] : wpool_threads( wpool_default() ));
+
+		size_t values[1000];
+		for ( size_t i = 0; i < 1000; i++ ) values[i] = i;
+		wpool_run( pool, squareTask, values, 1000, sizeof( size_t ));
+		for ( size_t i = 0; i < 1000; i++ )
+			if ( values[i] != i*i ) assert_true( false );
+		wpool_run( pool, squareTask, values, 0, sizeof( size_t ));
+		assert_equal( values[3], 9 );
+
+		PoolTestTask tasks[100];
+		for ( size_t i = 0; i < 100; i++ )
+			tasks[i] = (PoolTestTask){ .pool = pool, .number = i };
+		wpool_run( pool, nestedTask, tasks, 100, sizeof( PoolTestTask ));
+		size_t sum = 0;
+		for ( size_t i = 0; i < 100; i++ )
+			sum += tasks[i].result;
+		assert_equal( sum, 799ull*800*1599/6 );
+
+		wpool_delete( &pool );
+		assert_null( pool );
+	}
+	wpool_delete( &(WPool*){ NULL });
+	assert_true( wpool_default() == wpool_default() );
+}
 
 //--------------------------------------------------------------------------------
 
@@ -1156,6 +1406,51 @@ Test_warray_distinct()
 	assert_true( warray_one( array, wtypeStr_conditionEquals, NULL ));
 }
 void
+Test_warray_distinctKeepsFirst()
+{
+	//Hash based with int elements.
+	autoWArray* numbers = warray_new( 0, wtypeInt );
+	for ( size_t i = 0; i < 100000; i++ )
+		warray_append( numbers, (void*)((i * 7919) % 1000) );
+	warray_distinct( numbers );
+	assert_equal( numbers->size, 1000 );
+	for ( size_t i = 0; i < 1000; i++ )
+		assert_equal( (size_t)warray_at( numbers, i ), (i * 7919) % 1000 );
+
+	//Hash based with strings and NULLs.
+	autoWArray* strings = warray_new( 0, wtypeStr );
+	warray_append_n( strings, 7, (void*[]){ "dog", NULL, "cat", "dog", NULL, "bird", "cat" });
+	warray_distinct( strings );
+	assert_equal( strings->size, 4 );
+	assert_strequal( warray_at( strings, 0 ), "dog" );
+	assert_null( warray_at( strings, 1 ));
+	assert_strequal( warray_at( strings, 2 ), "cat" );
+	assert_strequal( warray_at( strings, 3 ), "bird" );
+
+	//Sort based for types without a hash method.
+	WType unhashed = *wtypeStr;
+	unhashed.hash = NULL;
+	autoWArray* words = warray_new( 0, &unhashed );
+	for ( int i = 0; i < 3000; i++ ) {
+		autoChar* word = __wstr_printf( "%d", (i * 31) % 500 );
+		warray_append( words, word );
+	}
+	warray_distinct( words );
+	assert_equal( words->size, 500 );
+	for ( int i = 0; i < 500; i++ ) {
+		autoChar* word = __wstr_printf( "%d", (i * 31) % 500 );
+		assert_strequal( warray_at( words, i ), word );
+	}
+
+	//Inline doubles, where -0.0 equals 0.0.
+	autoWArray* doubles = warray_newInline( 0, sizeof( double ), wtypeDouble );
+	warray_append_n( doubles, 6, (void*[]){ &(double){ 0.5 }, &(double){ 0.0 }, &(double){ 1.5 }, &(double){ 0.5 }, &(double){ -0.0 }, &(double){ 0.25 }});
+	warray_distinct( doubles );
+	assert_equal( doubles->size, 4 );
+	assert_equal( *(double*)warray_at( doubles, 0 ), 0.5 );
+	assert_equal( *(double*)warray_at( doubles, 3 ), 0.25 );
+}
+void
 Test_warray_reverse()
 {
 	autoWArray* array = a.new( 0, wtypeStr );
@@ -1387,11 +1682,1160 @@ Test_warray_doStuffWithIntElements()
     assert_true( warray_equal( array, fromString ));
 }
 
+
+//--------------------------------------------------------------------------------
+
+typedef struct CountingPool {
+	size_t allocs;
+	size_t frees;
+}CountingPool;
+
+static void*
+countingAlloc( void* context, size_t size )
+{
+	((CountingPool*)context)->allocs++;
+	return malloc( size );
+}
+static void*
+countingRealloc( void* context, void* pointer, size_t oldSize, size_t newSize )
+{
+	(void)context;
+	(void)oldSize;
+	return realloc( pointer, newSize );
+}
+static void
+countingFree( void* context, void* pointer )
+{
+	((CountingPool*)context)->frees++;
+	free( pointer );
+}
+void
+Test_warray_newWithAllocator()
+{
+	CountingPool pool = { 0 };
+	const WAllocator allocator = {
+		.alloc = countingAlloc,
+		.realloc = countingRealloc,
+		.free = countingFree,
+		.context = &pool
+	};
+
+	WArray* array = warray_newWithAllocator( 2, wtypeStr, &allocator );
+	assert_equal( pool.allocs, 1 );	//The array structure with its embedded data block
+
+	warray_append_n( array, 3, (void*[]){ "cat", "dog", "bird" });
+	assert_equal( pool.allocs, 5 );
+	assert_strequal( warray_at( array, 2 ), "bird" );
+
+	warray_removeFirst( array );
+	assert_equal( pool.frees, 1 );
+
+	//Stolen elements are ordinary heap elements.
+	autoChar* dog = warray_stealFirst( array );
+	assert_strequal( dog, "dog" );
+	assert_equal( pool.frees, 2 );
+
+	//Pushed elements are moved into the allocator.
+	char* lion = strdup( "lion" );
+	warray_pushLast( array, lion );
+	assert_null( lion );
+	assert_strequal( warray_last( array ), "lion" );
+
+	WArray* clone = warray_clone( array );
+	assert_true( warray_equal( array, clone ));
+
+	warray_delete( &array );
+	warray_delete( &clone );
+	assert_equal( pool.allocs, pool.frees );
+}
+
+void
+Test_warray_smallArrays()
+{
+	CountingPool pool = { 0 };
+	const WAllocator allocator = {
+		.alloc = countingAlloc,
+		.realloc = countingRealloc,
+		.free = countingFree,
+		.context = &pool
+	};
+
+	//Small arrays need a single allocation for the structure and the data.
+	WArray* array = warray_newWithAllocator( 0, wtypeInt, &allocator );
+	assert_equal( array->capacity, 8 );
+	for ( size_t i = 0; i < 8; i++ )
+		warray_append( array, (void*)i );
+	assert_equal( pool.allocs, 1 );
+
+	//Growing moves the data to a separate block.
+	warray_append( array, (void*)8 );
+	assert_equal( pool.allocs, 2 );
+	warray_append_n( array, 8, (void*[]){ 0, 0, 0, 0, 0, 0, 0, 0 });
+	assert_equal( pool.allocs, 2 );
+	assert_equal( array->size, 17 );
+	assert_equal( (size_t)warray_at( array, 8 ), 8 );
+
+	warray_delete( &array );
+	assert_equal( pool.frees, 2 );
+
+	//Large initial capacities get a separate data block from the start.
+	array = warray_newWithAllocator( 100, wtypeInt, &allocator );
+	assert_equal( pool.allocs, 4 );
+	warray_delete( &array );
+	assert_equal( pool.frees, 4 );
+
+	autoWArray* points = warray_newInline( 4, sizeof( double ), wtypeDouble );
+	warray_append_n( points, 5, (void*[]){ &(double){ 1.5 }, &(double){ 2.5 }, &(double){ 3.5 }, &(double){ 4.5 }, &(double){ 5.5 }});
+	assert_equal( *(double*)warray_last( points ), 5.5 );
+}
+//Deterministic random numbers, which leave the rand() sequence of the other tests untouched.
+static size_t
+testRandom( size_t* state )
+{
+	*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return *state >> 33;
+}
+
+void
+Test_warray_deque()
+{
+	autoWArray* queue = warray_new( 0, wtypeInt );
+
+	//Draining a queue while refilling it reuses the freed front slots.
+	for ( size_t i = 0; i < 1000; i++ )
+		warray_append( queue, (void*)i );
+	for ( size_t i = 0; i < 3000; i++ ) {
+		assert_equal( (size_t)warray_stealFirst( queue ), i );
+		warray_append( queue, (void*)(i+1000) );
+	}
+	assert_equal( queue->size, 1000 );
+	assert_true( queue->capacity < 2048 );
+
+	//Mixed operations at both ends and inside against a plain reference array.
+	enum { Max = 2000 };
+	size_t reference[Max];
+	size_t size = 0;
+	warray_clear( queue );
+	size_t seed = 7;
+	for ( size_t i = 0; i < 20000; i++ ) {
+		size_t position = size ? testRandom( &seed ) % size : 0;
+		switch ( size < Max ? testRandom( &seed ) % 6 : 3 ) {
+		case 0:
+			warray_prepend( queue, (void*)i );
+			memmove( &reference[1], &reference[0], size++ * sizeof( size_t ));
+			reference[0] = i;
+			break;
+		case 1:
+			warray_append( queue, (void*)i );
+			reference[size++] = i;
+			break;
+		case 2:
+			warray_insert( queue, position, (void*)i );
+			memmove( &reference[position+1], &reference[position], (size++ - position) * sizeof( size_t ));
+			reference[position] = i;
+			break;
+		default:
+			if ( not size ) break;
+			assert_equal( (size_t)warray_stealAt( queue, position ), reference[position] );
+			memmove( &reference[position], &reference[position+1], (--size - position) * sizeof( size_t ));
+			break;
+		}
+	}
+	assert_equal( queue->size, size );
+	for ( size_t i = 0; i < size; i++ )
+		assert_equal( (size_t)warray_at( queue, i ), reference[i] );
+
+	autoWArray* doubles = warray_newInline( 2, sizeof( double ), wtypeDouble );
+	for ( int i = 0; i < 100; i++ )
+		warray_prepend( doubles, &(double){ i } );
+	warray_removeFirst( doubles );
+	assert_equal( *(double*)warray_first( doubles ), 98 );
+	assert_equal( *(double*)warray_last( doubles ), 0 );
+	warray_sort( doubles );
+	assert_equal( *(double*)warray_first( doubles ), 0 );
+}
+
+void
+Test_warray_bulkInsert()
+{
+	autoWArray* array = warray_new( 0, wtypeStr );
+	for ( int i = 0; i < 100; i++ ) {
+		autoChar* string = __wstr_printf( "%d", i );
+		warray_append( array, string );
+	}
+
+	warray_insert_n( array, 60, 3, (void*[]){ "a", "b", "c" });
+	warray_insert_n( array, 10, 2, (void*[]){ "x", NULL });
+	assert_equal( array->size, 105 );
+	assert_strequal( warray_at( array, 9 ), "9" );
+	assert_strequal( warray_at( array, 10 ), "x" );
+	assert_null( warray_at( array, 11 ));
+	assert_strequal( warray_at( array, 12 ), "10" );
+	assert_strequal( warray_at( array, 62 ), "a" );
+	assert_strequal( warray_at( array, 64 ), "c" );
+	assert_strequal( warray_at( array, 65 ), "60" );
+
+	warray_prepend_n( array, 2, (void*[]){ "first", "second" });
+	assert_strequal( warray_at( array, 0 ), "first" );
+	assert_strequal( warray_at( array, 1 ), "second" );
+	assert_strequal( warray_at( array, 2 ), "0" );
+
+	//Setting over the end replaces the old elements and fills the gap with NULLs.
+	warray_set_n( array, 105, 4, (void*[]){ "p", "q", "r", "s" });
+	assert_equal( array->size, 109 );
+	assert_strequal( warray_at( array, 104 ), "97" );
+	assert_strequal( warray_at( array, 105 ), "p" );
+	warray_set_n( array, 110, 1, (void*[]){ "t" });
+	assert_null( warray_at( array, 109 ));
+	assert_strequal( warray_last( array ), "t" );
+
+	warray_insert_n( array, 120, 1, (void*[]){ "u" });
+	assert_equal( array->size, 121 );
+	assert_null( warray_at( array, 119 ));
+
+	autoWArray* slice = warray_slice( array, 10, 14 );
+	assert_equal( slice->size, 5 );
+	assert_strequal( warray_at( slice, 2 ), "x" );
+
+	warray_concat( slice, slice );
+	assert_equal( slice->size, 10 );
+	assert_strequal( warray_at( slice, 7 ), "x" );
+
+	autoWArray* numbers = warray_newInline( 0, sizeof( int ), NULL );
+	warray_append_n( numbers, 3, (void*[]){ &(int){ 1 }, &(int){ 2 }, &(int){ 3 }});
+	warray_concat( numbers, numbers );
+	warray_insert_n( numbers, 3, 2, (void*[]){ &(int){ 8 }, &(int){ 9 }});
+	int expected[] = { 1, 2, 3, 8, 9, 1, 2, 3 };
+	assert_equal( numbers->size, 8 );
+	for ( size_t i = 0; i < 8; i++ )
+		assert_equal( *(int*)warray_at( numbers, i ), expected[i] );
+}
+
+void
+Test_warray_hashIndex()
+{
+	//Apply the same operations to an indexed and a plain array and compare the lookups.
+	autoWArray* indexed = warray_enableIndex( warray_new( 0, wtypeInt ));
+	autoWArray* plain = warray_new( 0, wtypeInt );
+
+	size_t seed = 11;
+	for ( int i = 0; i < 5000; i++ ) {
+		WArray* arrays[] = { indexed, plain };
+		void* value = (void*)(size_t)(testRandom( &seed ) % 60);
+		size_t position = plain->size ? testRandom( &seed ) % plain->size : 0;
+		int operation = testRandom( &seed ) % 16;
+
+		for ( int j = 0; j < 2; j++ ) {
+			WArray* array = arrays[j];
+			switch ( operation ) {
+			case 0: case 1: case 2: warray_append( array, value ); break;
+			case 3: case 4: warray_prepend( array, value ); break;
+			case 5: warray_set( array, position, value ); break;
+			case 6: warray_insert( array, position, value ); break;
+			case 7: if ( array->size ) warray_removeFirst( array ); break;
+			case 8: if ( array->size ) warray_removeLast( array ); break;
+			case 9: if ( array->size ) warray_removeAt( array, position ); break;
+			case 10: if ( array->size ) warray_stealAt( array, position ); break;
+			case 11: warray_append_n( array, 3, (void*[]){ value, value, (void*)7 }); break;
+			case 12: warray_set_n( array, position+2, 2, (void*[]){ value, (void*)9 }); break;
+			case 13: warray_insert_n( array, position, 2, (void*[]){ (void*)8, value }); break;
+			case 14: if ( i % 20 == 0 ) warray_sort( array ); break;
+			case 15: if ( i % 50 == 0 ) warray_distinct( array ); else warray_set( array, plain->size+3, value ); break;
+			}
+		}
+
+		if ( i % 97 == 0 ) {
+			warray_clear( indexed );
+			warray_clear( plain );
+		}
+
+		void* key = (void*)(size_t)(testRandom( &seed ) % 62);
+		assert_equal( warray_index( indexed, key ), warray_index( plain, key ));
+		assert_equal( warray_rindex( indexed, key ), warray_rindex( plain, key ));
+	}
+	assert_true( warray_equal( indexed, plain ));
+
+	autoWArray* strings = warray_new( 0, wtypeStr );
+	warray_append_n( strings, 4, (void*[]){ "cat", NULL, "dog", "cat" });
+	warray_enableIndex( strings );
+	assert_true( warray_contains( strings, "dog" ));
+	assert_true( warray_contains( strings, NULL ));
+	assert_false( warray_contains( strings, "bird" ));
+	assert_equal( warray_index( strings, "cat" ), 0 );
+	assert_equal( warray_rindex( strings, "cat" ), 3 );
+	warray_removeFirst( strings );
+	assert_equal( warray_index( strings, "cat" ), 2 );
+	warray_disableIndex( strings );
+	assert_equal( warray_index( strings, "dog" ), 1 );
+}
+
+void
+Test_warray_strArena()
+{
+	autoWArray* array = warray_new( 0, wtypeStrArena );
+
+	for ( int i = 0; i < 10000; i++ ) {
+		autoChar* string = __wstr_printf( "line %d", i );
+		warray_append( array, string );
+	}
+	assert_equal( array->size, 10000 );
+	assert_strequal( warray_at( array, 1234 ), "line 1234" );
+
+	//Stolen strings are ordinary heap strings.
+	autoChar* last = warray_stealLast( array );
+	assert_strequal( last, "line 9999" );
+
+	warray_set( array, 0, "first" );
+	warray_append( array, NULL );
+	autoWArray* clone = warray_clone( array );
+	assert_true( warray_equal( array, clone ));
+
+	warray_clear( array );
+	assert_true( warray_empty( array ));
+
+	warray_append_n( array, 2, (void*[]){ "cat", "dog" });
+	assert_strequal( warray_first( array ), "cat" );
+	assert_strequal( warray_last( array ), "dog" );
+	warray_sort( clone );
+	assert_null( warray_first( clone ));
+}
+
+//--------------------------------------------------------------------------------
+
+typedef struct Point {
+	int x;
+	int y;
+}Point;
+
+static int
+comparePoint( const void* element1, const void* element2 )
+{
+	const Point* point1 = element1;
+	const Point* point2 = element2;
+	return point1->x != point2->x ? point1->x - point2->x : point1->y - point2->y;
+}
+static bool
+isRightOfOrigin( const void* element, const void* unused )
+{
+	(void)unused;
+	return ((const Point*)element)->x > 0;
+}
+void
+Test_warray_inlineDoubles()
+{
+	autoWArray* array = warray_newInline( 2, sizeof( double ), wtypeDouble );
+
+	warray_append( array, &(double){ 1.5 });
+	warray_append( array, &(double){ -1.0 });
+	warray_prepend( array, &(double){ 0 });
+	warray_insert( array, 1, &(double){ 3.141 });
+	assert_equal( array->size, 4 );
+	assert_dequal( *(double*)warray_at( array, 0 ), 0 );
+	assert_dequal( *(double*)warray_at( array, 1 ), 3.141 );
+	assert_dequal( *(double*)warray_at( array, 2 ), 1.5 );
+	assert_dequal( *(double*)warray_at( array, 3 ), -1.0 );
+
+	warray_sort( array );
+	assert_dequal( *(double*)warray_first( array ), -1.0 );
+	assert_dequal( *(double*)warray_last( array ), 3.141 );
+	assert_dequal( *(double*)warray_min( array ), -1.0 );
+	assert_dequal( *(double*)warray_max( array ), 3.141 );
+	assert_equal( warray_index( array, &(double){ 1.5 }), 2 );
+	assert_equal( warray_bsearch( array, wtypeDouble_compare, &(double){ 1.5 }), 2 );
+
+	autoWArray* clone = warray_clone( array );
+	assert_true( warray_equal( array, clone ));
+
+	autoChar* string = warray_toString( array, ", " );
+	assert_strequal( string, "-1.000000, 0.000000, 1.500000, 3.141000" );
+
+	double* stolen = warray_stealFirst( array );
+	assert_dequal( *stolen, -1.0 );
+	assert_equal( array->size, 3 );
+	free( stolen );
+
+	warray_set( array, 5, &(double){ 7.0 });
+	assert_equal( array->size, 6 );
+	assert_dequal( *(double*)warray_at( array, 3 ), 0 );
+	assert_dequal( *(double*)warray_at( array, 5 ), 7.0 );
+}
+void
+Test_warray_inlineRecords()
+{
+	static const WType pointType = { .compare = comparePoint };
+	autoWArray* array = warray_newInline( 0, sizeof( Point ), &pointType );
+
+	for ( int i = 0; i < 1000; i++ )
+		warray_append( array, &(Point){ 500-i, i });
+	assert_equal( array->size, 1000 );
+
+	warray_sort( array );
+	assert_equal( ((const Point*)warray_first( array ))->x, -499 );
+	assert_equal( ((const Point*)warray_last( array ))->x, 500 );
+
+	autoWArray* right = warray_filter( array, isRightOfOrigin, NULL );
+	assert_equal( right->size, 500 );
+	assert_true( warray_all( right, isRightOfOrigin, NULL ));
+
+	warray_unselect( array, isRightOfOrigin, NULL );
+	assert_equal( array->size, 500 );
+	assert_true( warray_none( array, isRightOfOrigin, NULL ));
+
+	autoWArray* slice = warray_slice( right, 0, 1 );
+	assert_equal( ((const Point*)warray_at( slice, 0 ))->x, 1 );
+	assert_equal( ((const Point*)warray_at( slice, 1 ))->x, 2 );
+
+	warray_reverse( slice );
+	assert_equal( ((const Point*)warray_at( slice, 0 ))->x, 2 );
+	assert_equal( ((const Point*)warray_at( slice, 1 ))->y, 499 );
+
+	Point* point = __wxnew( Point, 42, 42 );
+	warray_pushAt( slice, 0, point );
+	assert_null( point );
+	assert_equal( ((const Point*)warray_first( slice ))->y, 42 );
+
+	//The type has no clone method, inline elements are copied bytewise.
+	Point* copy = warray_cloneAt( slice, 1 );
+	assert_true( copy != warray_at( slice, 1 ));
+	assert_equal( copy->x, 2 );
+	free( copy );
+}
+
 //--------------------------------------------------------------------------------
 
 void
 Fuzztest_warray();
 
+static int
+reverseCompare( const void* element1, const void* element2 )
+{
+	return wtypeInt_compare( element2, element1 );
+}
+
+void
+Test_warray_sortPatterns()
+{
+	enum { Size = 3000, Values = 50 };
+	size_t seed = 13;
+
+	for ( int pattern = 0; pattern < 6; pattern++ ) {
+		autoWArray* ints = warray_new( 0, wtypeInt );
+		autoWArray* strings = warray_new( 0, wtypeStr );
+		autoWArray* doubles = warray_newInline( 0, sizeof( double ), wtypeDouble );
+		size_t counts[Values+1] = { 0 };
+
+		for ( size_t i = 0; i < Size; i++ ) {
+			size_t value;
+			switch ( pattern ) {
+			case 0:	value = testRandom( &seed ) % Values + 1;	break;	//Random
+			case 1:	value = i * Values / Size + 1;				break;	//Ascending
+			case 2:	value = Values - i * Values / Size;			break;	//Descending
+			case 3:	value = 7;									break;	//All equal
+			case 4:	value = i % Values + 1;						break;	//Sawtooth
+			default: value = (i < Size/2 ? i : Size-i) * Values / Size + 1;	//Organ pipe
+			}
+			counts[value]++;
+			char str[8];
+			snprintf( str, sizeof( str ), "%03zu", value );
+			warray_append( ints, (void*)value );
+			warray_append( strings, str );
+			warray_append( doubles, &(double){ value * 0.5 });
+		}
+		warray_append( strings, NULL );
+
+		warray_sort( ints );
+		warray_sort( strings );
+		warray_sort( doubles );
+		assert_null( warray_first( strings ));
+		for ( size_t i = 0; i < Size; i++ ) {
+			counts[(size_t)warray_at( ints, i )]--;
+			if ( i > 0 ) {
+				assert_true( (size_t)warray_at( ints, i-1 ) <= (size_t)warray_at( ints, i ));
+				assert_true( strcmp( warray_at( strings, i ), warray_at( strings, i+1 )) <= 0 );
+				assert_true( *(double*)warray_at( doubles, i-1 ) <= *(double*)warray_at( doubles, i ));
+			}
+		}
+		for ( size_t value = 0; value <= Values; value++ )
+			assert_equal( counts[value], 0 );
+	}
+
+	//A custom comparison takes the generic path.
+	autoWArray* descending = warray_new( 0, wtypeInt );
+	for ( size_t i = 0; i < Size; i++ )
+		warray_append( descending, (void*)(testRandom( &seed ) % 1000 + 1) );
+	warray_sortBy( descending, reverseCompare );
+	for ( size_t i = 1; i < Size; i++ )
+		assert_true( (size_t)warray_at( descending, i-1 ) >= (size_t)warray_at( descending, i ));
+}
+
+//Wrappers hiding the builtin comparisons, so the generic comparison sort is used.
+static int
+genericIntCompare( const void* element1, const void* element2 )
+{
+	return wtypeInt_compare( element1, element2 );
+}
+static int
+genericDoubleCompare( const void* element1, const void* element2 )
+{
+	return wtypeDouble_compare( element1, element2 );
+}
+static int
+genericStrCompare( const void* element1, const void* element2 )
+{
+	return wtypeStr_compare( element1, element2 );
+}
+
+void
+Test_warray_radixSort()
+{
+	enum { Size = 5000 };
+	size_t seed = 17;
+
+	autoWArray* ints = warray_new( 0, wtypeInt );
+	autoWArray* doubles = warray_new( 0, wtypeDouble );
+	autoWArray* strings = warray_new( 0, wtypeStr );
+	for ( size_t i = 0; i < Size; i++ ) {
+		long value = (long)testRandom( &seed ) - (1L << 30);
+		warray_append( ints, (void*)(value * (i % 3 ? 1 : 4096)) );
+
+		double number = value / 1000.0;
+		warray_append( doubles, i % 100 ? &number : NULL );
+
+		char str[200];
+		size_t length = testRandom( &seed ) % 180;	//Long common prefixes and empty strings.
+		memset( str, 'x', length );
+		snprintf( str + length, 20, "%zu", testRandom( &seed ) % 500 );
+		warray_append( strings, i % 50 ? str : i % 100 ? "" : NULL );
+	}
+
+	autoWArray* expectedInts = warray_sortBy( warray_clone( ints ), genericIntCompare );
+	autoWArray* expectedDoubles = warray_sortBy( warray_clone( doubles ), genericDoubleCompare );
+	autoWArray* expectedStrings = warray_sortBy( warray_clone( strings ), genericStrCompare );
+	warray_sort( ints );
+	warray_sort( doubles );
+	warray_sort( strings );
+
+	for ( size_t i = 0; i < Size; i++ ) {
+		assert_equal( warray_at( ints, i ), warray_at( expectedInts, i ));
+		assert_equal( wtypeDouble_compare( warray_at( doubles, i ), warray_at( expectedDoubles, i )), 0 );
+		assert_equal( wtypeStr_compare( warray_at( strings, i ), warray_at( expectedStrings, i )), 0 );
+	}
+	assert_true( (long)warray_first( ints ) < 0 );
+	assert_null( warray_first( doubles ));
+	assert_null( warray_first( strings ));
+}
+
+void
+Test_warray_sortParallel()
+{
+	enum { Size = 150000 };
+	size_t seed = 19;
+
+	autoWArray* ints = warray_new( Size, wtypeInt );
+	autoWArray* strings = warray_new( Size, wtypeStr );
+	autoWArray* doubles = warray_newInline( Size, sizeof( double ), wtypeDouble );
+	for ( size_t i = 0; i < Size; i++ ) {
+		size_t value = testRandom( &seed ) % 100000;
+		char str[16];
+		snprintf( str, sizeof( str ), "%zu", value );
+		warray_append( ints, (void*)value );
+		warray_append( strings, str );
+		warray_append( doubles, &(double){ value * -0.25 });
+	}
+	autoWArray* expectedInts = warray_sort( warray_clone( ints ));
+	autoWArray* expectedStrings = warray_sort( warray_clone( strings ));
+	autoWArray* expectedDoubles = warray_sort( warray_clone( doubles ));
+
+	for ( size_t threads = 0; threads <= 9; threads += 3 ) {
+		autoWArray* sortedInts = warray_sortParallel( warray_clone( ints ), genericIntCompare, threads );
+		autoWArray* sortedStrings = warray_sortParallel( warray_clone( strings ), wtypeStr_compare, threads );
+		autoWArray* sortedDoubles = warray_sortParallel( warray_clone( doubles ), wtypeDouble_compare, threads );
+		assert_true( warray_equal( sortedInts, expectedInts ));
+		assert_true( warray_equal( sortedStrings, expectedStrings ));
+		assert_true( warray_equal( sortedDoubles, expectedDoubles ));
+	}
+
+	autoWArray* reversed = warray_sortParallel( warray_clone( expectedInts ), reverseCompare, 8 );
+	warray_reverse( reversed );
+	assert_true( warray_equal( reversed, expectedInts ));
+}
+
+typedef struct Record {
+	size_t key;
+	size_t order;
+} Record;
+
+static size_t recordComparisons;
+
+static int
+compareRecordKeys( const void* element1, const void* element2 )
+{
+	recordComparisons++;
+	const Record* record1 = element1;
+	const Record* record2 = element2;
+	return (record1->key > record2->key) - (record1->key < record2->key);
+}
+
+void
+Test_warray_sortStable()
+{
+	size_t seed = 23;
+
+	for ( int pattern = 0; pattern < 6; pattern++ ) {
+		for ( size_t size = 1; size < 20000; size = size * 5 + 3 ) {
+			autoWArray* records = warray_newInline( size, sizeof( Record ), NULL );
+			for ( size_t i = 0; i < size; i++ ) {
+				size_t key;
+				switch ( pattern ) {
+				case 0:	key = testRandom( &seed ) % 10;					break;	//Many equal keys
+				case 1:	key = testRandom( &seed );						break;	//Random
+				case 2:	key = i < size-5 ? i : testRandom( &seed ) % size;	break;	//Appended to sorted
+				case 3:	key = size-i;									break;	//Descending
+				case 4:	key = (size-i) / 3;								break;	//Descending with equal keys
+				default: key = i % 100 < 50 ? i % 100 : testRandom( &seed ) % 200;	//Sorted runs
+				}
+				warray_append( records, &(Record){ key, i });
+			}
+
+			warray_sortStableBy( records, compareRecordKeys );
+			assert_equal( warray_size( records ), size );
+			for ( size_t i = 1; i < size; i++ ) {
+				const Record* previous = warray_at( records, i-1 );
+				const Record* record = warray_at( records, i );
+				if ( previous->key > record->key or (previous->key == record->key and previous->order > record->order ))
+					assert_true( false );
+			}
+		}
+	}
+
+	//Sorted input takes a single pass.
+	autoWArray* sorted = warray_newInline( 0, sizeof( Record ), NULL );
+	for ( size_t i = 0; i < 10000; i++ )
+		warray_append( sorted, &(Record){ i / 2, i });
+	recordComparisons = 0;
+	warray_sortStableBy( sorted, compareRecordKeys );
+	assert_true( recordComparisons < 20000 );	//Including the sorted postcondition
+
+	autoWArray* strings = warray_fromString( "dog, cat, (NULL), bird, cat", ", ", wtypeStr );
+	a.sortStable( strings );
+	assert_null( warray_first( strings ));
+	assert_strequal( warray_last( strings ), "dog" );
+}
+
+static size_t keyComputations;
+
+static void*
+lowerCaseKey( const void* element, const void* keyData )
+{
+	(void)keyData;
+	keyComputations++;
+	char* key = strdup( element );
+	for ( char* c = key; *c; c++ )
+		*c = tolower( (unsigned char)*c );
+	return key;
+}
+
+//keyData selects the record field to sort by.
+static void*
+recordFieldKey( const void* element, const void* keyData )
+{
+	const Record* record = element;
+	return (void*)(*(const char*)keyData == 'k' ? record->key : record->order);
+}
+
+void
+Test_warray_sortByKey()
+{
+	autoWArray* words = warray_fromString( "banana, Apple, cherry, apple, Banana", ", ", wtypeStr );
+	keyComputations = 0;
+	warray_sortByKey( words, lowerCaseKey, wtypeStr, NULL );
+	assert_equal( keyComputations, 5 );
+	assert_strequal( warray_at( words, 0 ), "Apple" );
+	assert_strequal( warray_at( words, 1 ), "apple" );
+	assert_strequal( warray_at( words, 2 ), "banana" );
+	assert_strequal( warray_at( words, 3 ), "Banana" );
+	assert_strequal( warray_at( words, 4 ), "cherry" );
+
+	size_t seed = 29;
+	autoWArray* records = warray_newInline( 0, sizeof( Record ), NULL );
+	for ( size_t i = 0; i < 1000; i++ )
+		warray_append( records, &(Record){ testRandom( &seed ) % 7 + 1, i+1 });
+	warray_sortByKeys( records, 2, (WSortKey[]){
+		{ .key = recordFieldKey, .type = wtypeInt, .data = "key", .descending = false },
+		{ .key = recordFieldKey, .type = wtypeInt, .data = "order", .descending = true }
+	});
+	for ( size_t i = 1; i < 1000; i++ ) {
+		const Record* previous = warray_at( records, i-1 );
+		const Record* record = warray_at( records, i );
+		assert_true( previous->key < record->key or (previous->key == record->key and previous->order > record->order ));
+	}
+
+	a.sortByKey( records, recordFieldKey, wtypeInt, "order" );
+	assert_equal( ((Record*)warray_first( records ))->order, 1 );
+	assert_equal( ((Record*)warray_last( records ))->order, 1000 );
+}
+
+void
+Test_warray_prefixes()
+{
+	//Apply the same operations to an array with and one without prefixes and compare the lookups.
+	const char* words[] = { "cat", "", NULL, "category", "categoryA", "categoryB", "dog", "\xff\xfe", "c" };
+	enum { Words = sizeof( words ) / sizeof( words[0] ) };
+	autoWArray* prefixed = warray_enablePrefixes( warray_new( 0, wtypeStr ));
+	autoWArray* plain = warray_new( 0, wtypeStr );
+
+	size_t seed = 31;
+	for ( int i = 0; i < 3000; i++ ) {
+		WArray* arrays[] = { prefixed, plain };
+		const char* word = words[testRandom( &seed ) % Words];
+		size_t position = plain->size ? testRandom( &seed ) % plain->size : 0;
+		int operation = testRandom( &seed ) % 12;
+
+		for ( int j = 0; j < 2; j++ ) {
+			WArray* array = arrays[j];
+			switch ( operation ) {
+			case 0: case 1: case 2: warray_append( array, word ); break;
+			case 3: warray_prepend( array, word ); break;
+			case 4: warray_set( array, position, word ); break;
+			case 5: warray_insert( array, position, word ); break;
+			case 6: if ( array->size ) warray_removeAt( array, position ); break;
+			case 7: if ( array->size ) warray_removeFirst( array ); break;
+			case 8: warray_set_n( array, position+1, 2, (void*[]){ (void*)word, "cat" }); break;
+			case 9: if ( i % 10 == 0 ) warray_reverse( array ); break;
+			case 10: if ( i % 20 == 0 ) warray_sort( array ); break;
+			case 11: if ( i % 200 == 0 ) warray_clear( array ); break;
+			}
+		}
+
+		const char* key = words[testRandom( &seed ) % Words];
+		assert_equal( warray_index( prefixed, key ), warray_index( plain, key ));
+		assert_equal( warray_rindex( prefixed, key ), warray_rindex( plain, key ));
+	}
+	assert_true( warray_equal( prefixed, plain ));
+
+	warray_sort( prefixed );
+	for ( size_t i = 0; i < Words; i++ ) {
+		ssize_t found = warray_bsearch( prefixed, wtypeStr_compare, words[i] );
+		if ( warray_contains( plain, words[i] ))
+			assert_equal( wtypeStr_compare( warray_at( prefixed, found ), words[i] ), 0 );
+		else
+			assert_equal( found, -1 );
+	}
+	assert_equal( warray_bsearch( prefixed, wtypeStr_compare, "categoryC" ), -1 );
+
+	warray_disablePrefixes( prefixed );
+	assert_true( warray_equal( prefixed, warray_sort( plain )));
+}
+
+void
+Test_warray_selection()
+{
+	size_t seed = 37;
+
+	for ( size_t range = 1; range <= 100000; range *= 100 ) {	//All equal, few and many duplicates
+		autoWArray* ints = warray_new( 0, wtypeInt );
+		for ( size_t i = 0; i < 3000; i++ )
+			warray_append( ints, (void*)(testRandom( &seed ) % range + 1) );
+		autoWArray* sorted = warray_sort( warray_clone( ints ));
+
+		for ( size_t n = 0; n < 3000; n += 299 ) {
+			autoWArray* selected = warray_nthElement( warray_clone( ints ), n );
+			assert_equal( warray_at( selected, n ), warray_at( sorted, n ));
+			for ( size_t i = 0; i < 3000; i++ ) {
+				if ( i < n and (size_t)warray_at( selected, i ) > (size_t)warray_at( sorted, n ))
+					assert_true( false );
+				if ( i > n and (size_t)warray_at( selected, i ) < (size_t)warray_at( sorted, n ))
+					assert_true( false );
+			}
+
+			autoWArray* partial = warray_partialSort( warray_clone( ints ), n );
+			for ( size_t i = 0; i < n; i++ )
+				if ( warray_at( partial, i ) != warray_at( sorted, i )) assert_true( false );
+
+			autoWArray* top = warray_topK( ints, n, reverseCompare );
+			assert_equal( warray_size( top ), n );
+			for ( size_t i = 0; i < n; i++ )
+				if ( warray_at( top, i ) != warray_at( sorted, 3000-1-i )) assert_true( false );
+		}
+		assert_true( warray_equal( warray_partialSort( ints, 5000 ), sorted ));
+	}
+
+	autoWArray* doubles = warray_newInline( 0, sizeof( double ), wtypeDouble );
+	for ( int i = 0; i < 101; i++ )
+		warray_append( doubles, &(double){ (i * 37) % 101 * 0.5 });
+	assert_equal( *(double*)warray_at( a.nthElement( doubles, 50 ), 50 ), 25.0 );
+	autoWArray* smallest = a.topK( doubles, 3, wtypeDouble_compare );
+	assert_equal( *(double*)warray_at( smallest, 2 ), 1.0 );
+	autoWArray* none = a.topK( doubles, 0, wtypeDouble_compare );
+	assert_true( warray_empty( none ));
+
+	autoWArray* words = warray_fromString( "pear, fig, apple, kiwi, date", ", ", wtypeStr );
+	a.partialSort( words, 2 );
+	assert_strequal( warray_at( words, 0 ), "apple" );
+	assert_strequal( warray_at( words, 1 ), "date" );
+}
+
+static bool
+isEvenNumber( const void* element, const void* conditionData )
+{
+	(void)conditionData;
+	return (size_t)element % 2 == 0;
+}
+static bool
+isBelow( const void* element, const void* limit )
+{
+	return *(const double*)element < *(const double*)limit;
+}
+static void*
+tripleNumber( const void* element, const void* mapData )
+{
+	(void)mapData;
+	return (void*)((size_t)element * 3);
+}
+static void*
+addDouble( const void* element, const void* intermediate )
+{
+	double* sum = malloc( sizeof( double ));
+	*sum = (intermediate ? *(const double*)intermediate : 0.0) + *(const double*)element;
+	return sum;
+}
+static void*
+addSums( const void* sum1, const void* sum2 )
+{
+	double element = sum2 ? *(const double*)sum2 : 0.0;
+	return addDouble( &element, sum1 );
+}
+void
+Test_warray_parallelIteration()
+{
+	size_t seed = 11;
+	autoWArray* numbers = warray_new( 0, wtypeInt );
+	autoWArray* doubles = warray_newInline( 0, sizeof( double ), wtypeDouble );
+	autoWArray* words = warray_new( 0, wtypeStr );
+	for ( size_t i = 0; i < 20000; i++ ) {
+		warray_append( numbers, (void*)(testRandom( &seed ) % 1000) );
+		warray_append( doubles, &(double){ testRandom( &seed ) % 1000 / 7.0 });
+		warray_append( words, i % 3 ? "cat" : "chimpanzee" );
+	}
+	autoWArray* even = warray_filter( numbers, isEvenNumber, NULL );
+	autoWArray* odd = warray_reject( numbers, isEvenNumber, NULL );
+	autoWArray* small = warray_filter( doubles, isBelow, &(double){ 50.0 });
+	autoWArray* longWords = warray_filter( words, isLongWord, NULL );
+	autoWArray* tripled = warray_map( numbers, tripleNumber, NULL, wtypeInt );
+	double* sum = warray_reduce( doubles, addDouble, NULL, wtypeDouble );
+
+	size_t threads[] = { 0, 1, 3 };
+	for ( size_t t = 0; t < 3; t++ ) {
+		autoWArray* even2 = warray_filterParallel( numbers, isEvenNumber, NULL, threads[t] );
+		assert_true( warray_equal( even, even2 ));
+		autoWArray* odd2 = warray_rejectParallel( numbers, isEvenNumber, NULL, threads[t] );
+		assert_true( warray_equal( odd, odd2 ));
+		autoWArray* small2 = warray_filterParallel( doubles, isBelow, &(double){ 50.0 }, threads[t] );
+		assert_true( warray_equal( small, small2 ));
+		autoWArray* longWords2 = a.filterParallel( words, isLongWord, NULL, threads[t] );
+		assert_true( warray_equal( longWords, longWords2 ));
+		assert_equal( warray_size( longWords2 ), 6667 );
+
+		autoWArray* tripled2 = a.mapParallel( numbers, tripleNumber, NULL, wtypeInt, threads[t] );
+		assert_true( warray_equal( tripled, tripled2 ));
+
+		double* sum1 = warray_reduceParallel( doubles, addDouble, addSums, NULL, wtypeDouble, 1 );
+		double* sum2 = a.reduceParallel( doubles, addDouble, addSums, NULL, wtypeDouble, threads[t] );
+		assert_true( *sum1 == *sum2 );	//Deterministic for any number of threads
+		assert_true( fabs( *sum1 - *sum ) < 1e-6 * *sum );
+		double* sum3 = warray_reduceParallel( doubles, addDouble, addSums, &(double){ 1000.0 }, wtypeDouble, threads[t] );
+		assert_true( fabs( *sum3 - *sum - 1000.0 ) < 1e-6 * *sum );
+		free( sum1 );
+		free( sum2 );
+		free( sum3 );
+	}
+
+	autoWArray* none = warray_new( 0, wtypeInt );
+	autoWArray* none2 = warray_filterParallel( none, isEvenNumber, NULL, 0 );
+	assert_true( warray_empty( none2 ));
+	autoWArray* none3 = warray_mapParallel( none, tripleNumber, NULL, NULL, 0 );
+	assert_true( warray_empty( none3 ));
+	double* start = warray_reduceParallel( none, addDouble, addSums, &(double){ 2.5 }, wtypeDouble, 0 );
+	assert_equal( *start, 2.5 );
+	free( start );
+	free( sum );
+}
+
+static bool
+isEqualPointer( const void* element, const void* conditionData )
+{
+	return element == conditionData;
+}
+void
+Test_warray_vectorScans()
+{
+	size_t seed = 5;
+	for ( size_t n = 0; n <= 1000; n += n < 40 ? 1 : 321 ) {
+		autoWArray* ints = warray_new( n, wtypeInt );
+		autoWArray* pointers = warray_new( n, wtypePtr );
+		for ( size_t i = 0; i < n; i++ ) {
+			long value = ((long)(testRandom( &seed ) % 9) - 4) * ((long)1 << 40) + (long)(i % 3);
+			warray_append( ints, (void*)value );
+			warray_append( pointers, (void*)(testRandom( &seed ) % 16 * 8) );
+		}
+
+		for ( long key = -4; key <= 4; key++ ) {
+			void* value = (void*)(key * ((long)1 << 40) + key % 3);
+			ssize_t first = -1, last = -1;
+			size_t count = 0;
+			for ( size_t i = 0; i < n; i++ ) {
+				if ( warray_at( ints, i ) != value ) continue;
+				if ( first < 0 ) first = i;
+				last = i;
+				count++;
+			}
+			assert_equal( warray_index( ints, value ), first );
+			assert_equal( warray_rindex( ints, value ), last );
+			assert_equal( warray_count( ints, wtypeInt_conditionEquals, value ), count );
+		}
+		assert_equal( warray_count( pointers, wtypePtr_conditionEquals, (void*)8 ), warray_count( pointers, isEqualPointer, (void*)8 ));
+
+		if ( n ) {
+			long minimum = (long)warray_at( ints, 0 ), maximum = minimum;
+			for ( size_t i = 1; i < n; i++ ) {
+				minimum = __wmin( minimum, (long)warray_at( ints, i ));
+				maximum = __wmax( maximum, (long)warray_at( ints, i ));
+			}
+			assert_equal( (long)warray_min( ints ), minimum );
+			assert_equal( (long)warray_max( ints ), maximum );
+		}
+
+		autoWArray* clone = warray_clone( ints );
+		assert_equal( warray_compare( ints, clone ), 0 );
+		if ( n ) {
+			size_t position = testRandom( &seed ) % n;
+			warray_set( clone, position, (void*)((long)warray_at( clone, position ) + 1) );
+			assert_equal( warray_compare( ints, clone ), -1 );
+			assert_equal( warray_compare( clone, ints ), 1 );
+			warray_removeLast( clone );
+			assert_equal( warray_compare( ints, clone ), position+1 == n ? 1 : -1 );
+		}
+	}
+}
+
+static bool
+countedLongWord( const void* element, const void* calls )
+{
+	(*(size_t*)calls)++;
+	return isLongWord( element, NULL );
+}
+static bool
+isEmptyString( const void* element, const void* conditionData )
+{
+	(void)conditionData;
+	return element and not *(const char*)element;
+}
+static void*
+wordLength( const void* element, const void* mapData )
+{
+	(void)mapData;
+	return (void*)strlen( element );
+}
+static void*
+addLength( const void* element, const void* intermediate )
+{
+	return (void*)((size_t)intermediate + (size_t)element);
+}
+void
+Test_warray_query()
+{
+	autoWArray* words = warray_fromString( "cat, sea-hawk, dog, chimpanzee, emu, wombat", ", ", wtypeStr );
+
+	autoWArray* longWords = wquery_collect( wquery_filter( warray_query( words ), isLongWord, NULL ));
+	autoWArray* filtered = warray_filter( words, isLongWord, NULL );
+	assert_true( warray_equal( longWords, filtered ));
+
+	autoWArray* good = wquery_collect( wquery_map( wquery_reject( a.query( words ), isLongWord, NULL ), makeItGood, "good", wtypeStr ));
+	assert_equal( warray_size( good ), 3 );
+	assert_strequal( warray_at( good, 0 ), "My cat is good." );
+	assert_strequal( warray_at( good, 2 ), "My emu is good." );
+
+	//Stages after a map see the mapped elements.
+	autoWArray* goodLong = wquery_collect( wquery_filter(
+		wquery_map( warray_query( words ), makeItGood, "very good", wtypeStr ), isLongWord, NULL ));
+	assert_equal( warray_size( goodLong ), 6 );
+
+	size_t total = (size_t)wquery_reduce( wquery_map( wquery_filter( warray_query( words ), isLongWord, NULL ),
+		wordLength, NULL, wtypeInt ), addLength, NULL, wtypeInt );
+	assert_equal( total, 8 + 10 + 6 );
+
+	autoChar* joined = wquery_reduce( warray_query( words ), joinAnimals, "turtle", wtypeStr );
+	autoChar* joined2 = warray_reduce( words, joinAnimals, "turtle", wtypeStr );
+	assert_strequal( joined, joined2 );
+	autoChar* none = wquery_reduce( wquery_filter( warray_query( words ), isEmptyString, NULL ), joinAnimals, "turtle", wtypeStr );
+	assert_strequal( none, "turtle" );
+
+	assert_equal( wquery_count( wquery_filter( warray_query( words ), isLongWord, NULL )), 3 );
+	assert_true( wquery_any( wquery_filter( warray_query( words ), isLongWord, NULL )));
+	assert_false( wquery_any( wquery_filter( warray_query( words ), isEmptyString, NULL )));
+
+	//The query stops at the first element found.
+	size_t calls = 0;
+	autoChar* first = wquery_first( wquery_map( wquery_filter( warray_query( words ), countedLongWord, &calls ),
+		makeItGood, "fast", wtypeStr ));
+	assert_strequal( first, "My sea-hawk is fast." );
+	assert_equal( calls, 2 );
+	autoChar* firstWord = wquery_first( warray_query( words ));
+	assert_strequal( firstWord, "cat" );
+	assert_true( wquery_first( wquery_filter( warray_query( words ), isEmptyString, NULL )) == WElementNotFound );
+
+	autoWArray* doubles = warray_newInline( 0, sizeof( double ), wtypeDouble );
+	for ( int i = 0; i < 10; i++ )
+		warray_append( doubles, &(double){ i * 10.0 });
+	autoWArray* small = wquery_collect( wquery_filter( warray_query( doubles ), isBelow, &(double){ 35.0 }));
+	assert_equal( warray_size( small ), 4 );
+	assert_equal( *(double*)warray_at( small, 3 ), 30.0 );
+
+	//The first element of an inline array is a copy, not the slot.
+	double* firstDouble = wquery_first( wquery_reject( warray_query( doubles ), isBelow, &(double){ 35.0 }));
+	assert_true( firstDouble != warray_at( doubles, 4 ));
+	assert_equal( *firstDouble, 40.0 );
+	free( firstDouble );
+	static const WType pointType = { .compare = comparePoint };
+	autoWArray* points = warray_newInline( 0, sizeof( Point ), &pointType );
+	warray_append( points, &(Point){ 3, 4 });
+	Point* firstPoint = wquery_first( warray_query( points ));
+	assert_true( firstPoint != warray_at( points, 0 ));
+	assert_equal( firstPoint->y, 4 );
+	free( firstPoint );
+
+	WQuery* unused = wquery_map( warray_query( words ), makeItGood, "unused", wtypeStr );
+	wquery_delete( &unused );
+	assert_null( unused );
+	wquery_delete( &unused );
+}
+
+static void
+appendWord( const void* element, void* buf, const void* separator )
+{
+	wstrbuf_printf( buf, "%s%s", (const char*)element, (const char*)separator );
+}
+static void
+sumDouble( const void* element, void* sum, const void* unused )
+{
+	(void)unused;
+	*(double*)sum += *(const double*)element;
+}
+void
+Test_warray_fold()
+{
+	autoWArray* words = warray_fromString( "cat, sea-hawk, dog", ", ", wtypeStr );
+
+	WStrBuf* buf = a.fold( words, appendWord, wstrbuf_new( 0 ), "; " );
+	assert_strequal( buf->string, "cat; sea-hawk; dog; " );
+	wstrbuf_delete( &buf );
+
+	double sum = 0.5;
+	autoWArray* doubles = warray_newInline( 0, sizeof( double ), wtypeDouble );
+	assert_true( warray_fold( doubles, sumDouble, &sum, NULL ) == &sum );
+	assert_equal( sum, 0.5 );
+	for ( int i = 1; i <= 100; i++ )
+		warray_append( doubles, &(double){ i });
+	warray_fold( doubles, sumDouble, &sum, NULL );
+	assert_equal( sum, 5050.5 );
+
+	WStrBuf* goodBuf = wstrbuf_new( 0 );
+	wquery_fold( wquery_map( wquery_filter( warray_query( words ), isLongWord, NULL ), makeItGood, "big", wtypeStr ),
+		appendWord, goodBuf, "" );
+	assert_strequal( goodBuf->string, "My sea-hawk is big." );
+	wstrbuf_delete( &goodBuf );
+}
+
+static bool
+startsWithC( const void* element, const void* conditionData )
+{
+	(void)conditionData;
+	return element and *(const char*)element == 'c';
+}
+static void
+sumPositions( const void* element, size_t position, void* sum )
+{
+	(void)element;
+	*(size_t*)sum += position;
+}
+void
+Test_warray_selectionVectors()
+{
+	autoWArray* words = warray_fromString( "cat, sea-hawk, cow, chimpanzee, emu, crocodile, dog", ", ", wtypeStr );
+
+	WSelection* longWords = a.filterIndices( words, isLongWord, NULL );
+	WSelection* cWords = warray_filterIndices( words, startsWithC, NULL );
+	assert_equal( longWords->size, 7 );
+	assert_equal( wselection_count( longWords ), 3 );
+	assert_true( wselection_contains( longWords, 1 ));
+	assert_false( wselection_contains( longWords, 0 ));
+
+	autoWArray* gathered = warray_gather( words, longWords );
+	autoWArray* filtered = warray_filter( words, isLongWord, NULL );
+	assert_true( warray_equal( gathered, filtered ));
+	assert_equal( gathered->capacity, 3 );
+
+	WSelection* both = wselection_or( wselection_new( 7 ), longWords );
+	wselection_and( both, cWords );
+	autoWArray* longCWords = a.gather( words, both );
+	assert_strequal( warray_at( longCWords, 0 ), "chimpanzee" );
+	assert_strequal( warray_at( longCWords, 1 ), "crocodile" );
+	assert_equal( warray_size( longCWords ), 2 );
+
+	wselection_or( wselection_not( both ), cWords );
+	autoWArray* positions = wselection_positions( both );
+	assert_equal( warray_size( positions ), 7 );
+	wselection_not( both );
+	assert_equal( wselection_count( both ), 0 );
+
+	//Chained filters only check the elements still selected.
+	size_t calls = 0;
+	a.filterSelected( words, cWords, countedLongWord, &calls );
+	assert_equal( calls, 4 );
+	autoWArray* cPositions = wselection_positions( cWords );
+	assert_equal( warray_size( cPositions ), 2 );
+	assert_equal( (size_t)warray_at( cPositions, 0 ), 3 );
+	assert_equal( (size_t)warray_at( cPositions, 1 ), 5 );
+
+	size_t sum = 0;
+	a.foreachSelected( words, cWords, sumPositions, &sum );
+	assert_equal( sum, 8 );
+
+	wselection_delete( &longWords );
+	wselection_delete( &cWords );
+	wselection_delete( &both );
+	assert_null( both );
+	wselection_delete( &both );
+
+	//Word boundaries and the unused bits of the last word.
+	for ( size_t n = 0; n <= 200; n += 13 ) {
+		autoWArray* numbers = warray_new( n, wtypeInt );
+		for ( size_t i = 0; i < n; i++ )
+			warray_append( numbers, (void*)i );
+		WSelection* even = warray_filterIndices( numbers, isEvenNumber, NULL );
+		assert_equal( wselection_count( even ), (n+1) / 2 );
+		assert_equal( wselection_count( wselection_not( even )), n / 2 );
+		wselection_not( wselection_not( even ));
+		autoWArray* odd = warray_gather( numbers, even );
+		autoWArray* odd2 = warray_reject( numbers, isEvenNumber, NULL );
+		assert_true( warray_equal( odd, odd2 ));
+		if ( n ) {
+			wselection_set( even, n-1, true );
+			assert_true( wselection_contains( even, n-1 ));
+		}
+		wselection_delete( &even );
+	}
+
+	autoWArray* doubles = warray_newInline( 0, sizeof( double ), wtypeDouble );
+	for ( int i = 0; i < 100; i++ )
+		warray_append( doubles, &(double){ i });
+	WSelection* small = warray_filterIndices( doubles, isBelow, &(double){ 3.0 });
+	autoWArray* smallDoubles = warray_gather( doubles, small );
+	assert_equal( warray_size( smallDoubles ), 3 );
+	assert_equal( *(double*)warray_at( smallDoubles, 2 ), 2.0 );
+	wselection_delete( &small );
+}
+
 int main() {
 	printf( "\n" );
 
@@ -1404,12 +2848,14 @@ int main() {
 	testsuite( Test_warray_prepend_strings );
 	testsuite( Test_warray_insert_strings );
 	testsuite( Test_warray_insertSorted );
+	testsuite( Test_warray_insertSortedMany );
 	testsuite( Test_warray_set );
 	testsuite( Test_warray_append_n );
 	testsuite( Test_warray_prepend_n );
 	testsuite( Test_warray_set_n );
 
 	testsuite( Test_warray_pushAt );
+	testsuite( Test_warray_pushInsert_n );
 
 	testsuite( Test_warray_firstLastSampleEmptyNonEmpty );
 	testsuite( Test_warray_cloneFirstLastAt );
@@ -1425,12 +2871,22 @@ int main() {
 	testsuite( Test_warray_unselect );
 	testsuite( Test_warray_map );
 	testsuite( Test_warray_reduce );
+	testsuite( Test_warray_parallelIteration );
+	testsuite( Test_warray_vectorScans );
+	testsuite( Test_warray_query );
+	testsuite( Test_warray_fold );
+	testsuite( Test_warray_selectionVectors );
 
 	testsuite( Test_warray_minMax );
 	testsuite( Test_warray_indexRindex );
 	testsuite( Test_warray_count );
 
 	testsuite( Test_warray_toStringFromString );
+	testsuite( Test_warray_toStringLarge );
+	testsuite( Test_warray_splitView );
+	testsuite( Test_warena );
+	testsuite( Test_wstrbuf );
+	testsuite( Test_wpool );
 	testsuite( Test_warray_foreach );
 	testsuite( Test_warray_foreachIndex );
 	testsuite( Test_warray_allAnyOneNone );
@@ -1438,6 +2894,7 @@ int main() {
 	testsuite( Test_warray_sort );
 	testsuite( Test_warray_compact );
 	testsuite( Test_warray_distinct );
+	testsuite( Test_warray_distinctKeepsFirst );
 	testsuite( Test_warray_reverse );
 	testsuite( Test_warray_shuffle );
 	testsuite( Test_warray_concat );
@@ -1448,6 +2905,21 @@ int main() {
 
 	testsuite( Test_warray_doStuffWithDoubleElements );
 	testsuite( Test_warray_doStuffWithIntElements );
+	testsuite( Test_warray_newWithAllocator );
+	testsuite( Test_warray_smallArrays );
+	testsuite( Test_warray_deque );
+	testsuite( Test_warray_bulkInsert );
+	testsuite( Test_warray_hashIndex );
+	testsuite( Test_warray_strArena );
+	testsuite( Test_warray_inlineDoubles );
+	testsuite( Test_warray_inlineRecords );
+	testsuite( Test_warray_sortPatterns );
+	testsuite( Test_warray_radixSort );
+	testsuite( Test_warray_sortParallel );
+	testsuite( Test_warray_sortStable );
+	testsuite( Test_warray_sortByKey );
+	testsuite( Test_warray_prefixes );
+	testsuite( Test_warray_selection );
 
 	testsuite( Fuzztest_warray );
 
@@ -20,7 +20,14 @@
 #include <iso646.h>	//and, or, not
 #include <string.h>	//memmove, memset
 #include <stdarg.h>	//va_list
-#include <stdlib.h>	//free, rand, bsearch, qsort
+#include <stdlib.h>	//free, rand, bsearch
+#include <stdint.h>	//uint64_t, intptr_t
+
+//Vector scans need 64 bit slots and the target attribute of GCC and Clang for runtime dispatch.
+#if defined( __GNUC__ ) and defined( __x86_64__ ) and UINTPTR_MAX == UINT64_MAX
+#define WARRAY_VECTOR_SCANS
+#include <immintrin.h>	//AVX2 and SSE4.2 intrinsics
+#endif
 
 //-------------------------------------------------------------------------------
 //	Invariants check, performed after every public function
@@ -32,8 +39,8 @@ checkArray( const WArray* array ) {
 	assert( array->size <= array->capacity );
 	assert( array->data );
 	assert( array->type );
-	assert( array->type->clone );
-	assert( array->type->delete );
+	assert( array->elementSize or array->type->clone );
+	assert( array->elementSize or array->type->delete );
 
 	return (WArray*)array;
 }
@@ -71,1066 +78,4094 @@ __wstr_sep_r( char string[], const char delimiters[], char** next )
 }
 
 //-------------------------------------------------------------------------------
+//	Element slots
 //-------------------------------------------------------------------------------
 
-const WType* wtypeArray = &(WType){
-	.clone = (WElementClone*)warray_clone,
-	.delete = (WElementDelete*)warray_delete,
-	.compare = (WElementCompare*)warray_compare,
-	.fromString = (WElementFromString*)warray_fromString,
-	.toString = (WElementToString*)warray_toString
-};
+/*	The data block is a sequence of slots. For pointer arrays (elementSize == 0) a slot holds
+	the element pointer, for inline arrays it holds the element bytes themselves. The element
+	methods always get the element pointer, i.e. the address of the slot for inline arrays.
+*/
+static inline size_t
+slotSize( const WArray* array )
+{
+	return array->elementSize ? array->elementSize : sizeof(void*);
+}
 
-enum ArrayParameters {
-	ArrayDefaultCapacity 	= 100,
-	ArrayGrowthRate 		= 2,
-};
+static inline char*
+slotAt( const WArray* array, size_t position )
+{
+	return (char*)array->data + position * slotSize( array );
+}
 
-//-------------------------------------------------------------------------------
-//-------------------------------------------------------------------------------
+static inline void*
+elementAt( const WArray* array, size_t position )
+{
+	return array->elementSize ? slotAt( array, position ) : array->data[position];
+}
 
-WArray*
-warray_new( size_t capacity, const WType* type )
+//The allocator passed to the cloneWith() and deleteWith() methods.
+static inline const WAllocator*
+elementAllocator( const WArray* array )
 {
-	assert( not type or type->clone );
-	assert( not type or type->delete );
+	return array->arena ? warena_allocator( array->arena ) : array->allocator;
+}
 
-	WArray* array = __wxnew( WArray,
-		.capacity	= capacity ? capacity : ArrayDefaultCapacity,
-		.type		= type ? type : wtypePtr,
-	);
-	array->data = __wxmalloc( array->capacity * sizeof(void*) );
+//Clone an element with the array's allocator if the type supports it.
+static inline void*
+cloneElement( const WArray* array, const void* element )
+{
+	assert( element );
 
-	assert( array );
-	return checkArray( array );
+	const WType* type = array->type;
+	return type->cloneWith ? type->cloneWith( element, elementAllocator( array )) : type->clone( element );
 }
 
-WArray*
-warray_clone( const WArray* array )
+static inline void
+deleteElement( const WArray* array, void** element )
 {
-	assert( array );
+	assert( element );
 
-	WArray *copy = __wxnew( WArray,
-		.size		= array->size,
-		.capacity	= array->capacity,
-		.data		= __wxmalloc( sizeof( void* ) * array->capacity ),
-		.type		= array->type
-	);
+	const WType* type = array->type;
+	if ( type->cloneWith )
+		type->deleteWith( element, elementAllocator( array ));
+	else
+		type->delete( element );
+}
 
-	for ( size_t i = 0; i < array->size; i++ ) {
-		if ( array->data[i] )
-			copy->data[i] = array->type->clone( array->data[i] );
+//Copy the element into the slot, NULL elements become NULL pointers resp. zeroed inline elements.
+static void
+storeAt( WArray* array, size_t position, const void* element )
+{
+	if ( array->elementSize ) {
+		if ( element )
+			memcpy( slotAt( array, position ), element, array->elementSize );
 		else
-			copy->data[i] = NULL;
+			memset( slotAt( array, position ), 0, array->elementSize );
 	}
+	else
+		array->data[position] = element ? cloneElement( array, element ) : NULL;
+}
 
-	assert( copy );
-	assert( not array->type->compare or warray_equal( array, copy ));
-	return checkArray( copy );
+//Release the element in the slot. Inline elements own no resources.
+static void
+deleteAt( WArray* array, size_t position )
+{
+	if ( array->elementSize ) return;
+
+	deleteElement( array, &array->data[position] );
 }
 
-void
-warray_delete( WArray** arrayPtr )
+//Return an allocated copy of an element of the array, which is owned by the caller afterwards.
+static void*
+copyElement( const WArray* array, const void* element )
 {
-	if ( not arrayPtr ) return;
+	if ( array->elementSize )
+		return memcpy( __wxmalloc( array->elementSize ), element, array->elementSize );
 
-	WArray* array = *arrayPtr;
+	return element ? array->type->clone( element ) : NULL;
+}
 
-	warray_clear( array );
-	free( array->data );
-	free( array );
-	*arrayPtr = NULL;
+//Return an allocated copy of the element at the position, see copyElement().
+static void*
+copyAt( const WArray* array, size_t position )
+{
+	return copyElement( array, elementAt( array, position ));
 }
 
-WArray*
-warray_clear( WArray* array )
+//Hand the element over to the caller, who expects it to be allocated like the clone() method does.
+static void*
+releaseAt( WArray* array, size_t position )
 {
-	if ( not array ) return array;
+	if ( array->elementSize or not array->type->cloneWith or elementAllocator( array ) == wallocatorDefault )
+		return array->elementSize ? copyAt( array, position ) : array->data[position];
 
-	for ( size_t i = 0; i < array->size; i++ ) {
-		assert( &array->data[i] );
-		array->type->delete( &array->data[i] );
-	}
+	void* element = copyAt( array, position );
+	deleteAt( array, position );
+	return element;
+}
 
-	array->size = 0;
+//Take over an element allocated like the clone() method does.
+static void*
+adoptElement( const WArray* array, void* element )
+{
+	if ( not element or not array->type->cloneWith or elementAllocator( array ) == wallocatorDefault )
+		return element;
 
-	assert( array );
-	assert( warray_empty( array ));
-	return checkArray( array );
+	void* copy = cloneElement( array, element );
+	array->type->delete( &element );
+	return copy;
 }
 
-void
-warray_assign( WArray** arrayPointer, WArray* other )
+static inline void
+moveSlots( WArray* array, size_t to, size_t from, size_t count )
 {
-	if ( not arrayPointer ) return;
-	WArray* array = *arrayPointer;
+	memmove( slotAt( array, to ), slotAt( array, from ), count * slotSize( array ));
+}
 
-	assert( array->type == other->type && "Can only assign arrays of the same type." );
+static inline void
+zeroSlots( WArray* array, size_t from, size_t count )
+{
+	memset( slotAt( array, from ), 0, count * slotSize( array ));
+}
 
-	warray_delete( arrayPointer );
-	*arrayPointer = other;
+static inline void
+copySlot( WArray* array, size_t to, size_t from )
+{
+	if ( array->elementSize )
+		memcpy( slotAt( array, to ), slotAt( array, from ), array->elementSize );
+	else
+		array->data[to] = array->data[from];
+}
 
-	checkArray( *arrayPointer );
+static void
+swapSlots( WArray* array, size_t position1, size_t position2 )
+{
+	if ( not array->elementSize ) {
+		__wswapPtr( array->data[position1], array->data[position2] );
+		return;
+	}
+
+	char* slot1 = slotAt( array, position1 );
+	char* slot2 = slotAt( array, position2 );
+	for ( size_t i = 0; i < array->elementSize; i++ ) {
+		char temp = slot1[i];
+		slot1[i] = slot2[i];
+		slot2[i] = temp;
+	}
 }
 
 //-------------------------------------------------------------------------------
+//	Prefix cache
 //-------------------------------------------------------------------------------
 
-//Resize the array if necessary, so that it can take the new size.
-static void
-resize( WArray* array, size_t newSize )
-{
-	if ( newSize <= array->capacity ) return;
+/*	Abbreviated keys of string elements: The first eight bytes of every string as a big-endian
+	number, so most comparisons are decided without touching the strings. Only the keys of the
+	first count elements are valid. Changes cut count back to their position and lookups
+	compute the missing keys, so appending costs nothing until the next lookup.
+*/
+struct WArrayPrefixes {
+	uint64_t*	keys;
+	size_t		count;
+	size_t		capacity;
+};
 
-	array->capacity = __wmax( newSize, array->capacity * ArrayGrowthRate );
-	array->data = __wxrealloc( array->data, array->capacity * sizeof(void*));
-	assert( array->capacity >= newSize );
-	checkArray( array );
+//The first eight bytes of the string as a big-endian number, equal prefixes need strcmp().
+static inline uint64_t
+stringPrefix( const char* string )
+{
+	uint64_t prefix = 0;
+	for ( int i = 0; string and i < 8 and string[i]; i++ )
+		prefix |= (uint64_t)(unsigned char)string[i] << (56 - 8*i);
+	return prefix;
 }
 
-static WArray*
-put( WArray* array, size_t position, const void* element )
+//Forget the keys from the position on.
+static inline void
+truncatePrefixes( const WArray* array, size_t position )
 {
-	assert( array );
-	assert( position < array->capacity );
+	if ( array->prefixes ) array->prefixes->count = __wmin( array->prefixes->count, position );
+}
 
-	if ( element )
-		array->data[position] = array->type->clone( element );
-	else
-		array->data[position] = NULL;
-	array->size = __wmax( array->size+1, position+1 );
+//Compute the missing keys up to the array size.
+static const uint64_t*
+updatePrefixes( const WArray* array )
+{
+	WArrayPrefixes* prefixes = array->prefixes;
+	if ( prefixes->capacity < array->size ) {
+		prefixes->capacity = __wmax( array->size, 2 * prefixes->capacity );
+		prefixes->keys = __wxrealloc( prefixes->keys, prefixes->capacity * sizeof( uint64_t ));
+	}
+	for ( ; prefixes->count < array->size; prefixes->count++ )
+		prefixes->keys[prefixes->count] = stringPrefix( array->data[prefixes->count] );
 
-	assert( array );
-	assert( array->size > position );
-	assert( array->capacity > position );
-	return checkArray( array );
+	return prefixes->keys;
 }
 
-WArray*
-warray_append( WArray* array, const void* element )
+//Linear search comparing the keys first, return the first or last position of an equal string or -1.
+static ssize_t
+prefixLookup( const WArray* array, const char* string, bool last )
 {
-	assert( array );
-
-	resize( array, array->size+1 );
+	const uint64_t* keys = updatePrefixes( array );
+	uint64_t prefix = stringPrefix( string );
+	for ( size_t i = 0; i < array->size; i++ ) {
+		size_t position = last ? array->size-1-i : i;
+		if ( keys[position] == prefix and wtypeStr_compare( string, array->data[position] ) == 0 )
+			return position;
+	}
 
-	return checkArray( put( array, array->size, element ));
+	return -1;
 }
 
-WArray*
-warray_prepend( WArray* array, const void* element )
+//Binary search comparing the keys first, return the position of an equal string or -1.
+static ssize_t
+prefixSearch( const WArray* array, const char* string )
 {
-	assert( array );
+	const uint64_t* keys = updatePrefixes( array );
+	uint64_t prefix = stringPrefix( string );
+	size_t low = 0, high = array->size;
+	while ( low < high ) {
+		size_t middle = low + (high-low) / 2;
+		int result = prefix != keys[middle] ? (prefix > keys[middle]) - (prefix < keys[middle])
+			: wtypeStr_compare( string, array->data[middle] );
+		if ( result == 0 )
+			return middle;
+		if ( result < 0 )
+			high = middle;
+		else
+			low = middle+1;
+	}
 
-	resize( array, array->size+1 );
-	memmove( &array->data[1], &array->data[0], array->size * sizeof(void*));
+	return -1;
+}
+
+static void
+deletePrefixes( WArrayPrefixes** prefixesPtr )
+{
+	if ( not *prefixesPtr ) return;
 
-	return checkArray( put( array, 0, element ));
+	free( (*prefixesPtr)->keys );
+	free( *prefixesPtr );
+	*prefixesPtr = NULL;
 }
 
-WArray*
-warray_set( WArray* array, size_t position, const void* element )
+//-------------------------------------------------------------------------------
+//	Hash index
+//-------------------------------------------------------------------------------
+
+/*	An open addressing hash table with linear probing, mapping element hashes to element
+	positions. The positions are stored with an offset, so adding or removing elements at
+	the front only changes the offset instead of every entry. Modifications, which would
+	need to touch many entries, mark the index as stale and it gets rebuilt at the next lookup.
+*/
+typedef struct IndexEntry {
+	size_t	hash;
+	size_t	position;	//Element position plus the index offset
+	bool	used;
+}IndexEntry;
+
+struct WArrayIndex {
+	IndexEntry*	entries;
+	size_t		buckets;	//A power of two
+	size_t		count;
+	size_t		offset;
+	bool		stale;
+};
+
+static void
+indexInsert( WArrayIndex* index, size_t hash, size_t position )
 {
-	assert( array );
+	size_t bucket = hash & (index->buckets-1);
+	while ( index->entries[bucket].used )
+		bucket = (bucket+1) & (index->buckets-1);
 
-	resize( array, __wmax( array->size, position+1 ));
+	index->entries[bucket] = (IndexEntry){ .hash = hash, .position = position + index->offset, .used = true };
+	index->count++;
+}
 
-	if ( position < array->size ) {	//Delete the old element.
-		assert( &array->data[position] );
-		array->type->delete( &array->data[position] );
-	}
-	else {							//Fill the gap with zeroes.
-		memset( &array->data[array->size], 0, (position-array->size) * sizeof(void*));
-		array->size = position+1;
+//Fill the index from scratch with at most a quarter of the buckets in use.
+static void
+rebuildIndex( const WArray* array )
+{
+	WArrayIndex* index = array->index;
+
+	size_t buckets = 16;
+	while ( buckets < 4 * array->size ) buckets *= 2;
+	if ( buckets != index->buckets ) {
+		free( index->entries );
+		index->entries = __wxmalloc( buckets * sizeof( IndexEntry ));
+		index->buckets = buckets;
 	}
+	memset( index->entries, 0, buckets * sizeof( IndexEntry ));
+	index->count = 0;
+	index->offset = 0;
+	index->stale = false;
 
-	if ( element )
-		array->data[position] = array->type->clone( element );
-	else
-		array->data[position] = NULL;
-
-	assert( array );
-	return checkArray( array );
+	for ( size_t i = 0; i < array->size; i++ )
+		indexInsert( index, array->type->hash( elementAt( array, i )), i );
 }
 
-WArray*
-warray_insert( WArray* array, size_t position, const void* element )
+static void
+invalidateIndex( WArray* array )
 {
-	assert( array );
+	truncatePrefixes( array, 0 );
+	if ( array->index ) array->index->stale = true;
+}
 
-	resize( array, __wmax( array->size+1, position+1 ));
+//Add the element at the position, a full index gets rebuilt bigger later.
+static void
+indexAdd( WArray* array, size_t position )
+{
+	truncatePrefixes( array, position );
+	WArrayIndex* index = array->index;
+	if ( not index or index->stale ) return;
 
-	if ( position < array->size )	//Make room for the new element.
-		memmove( &array->data[position+1], &array->data[position], (array->size-position) * sizeof(void*));
-	else							//Fill the gap with zeros.
-		memset( &array->data[array->size], 0, (position-array->size) * sizeof(void*));
+	if ( 2 * (index->count+1) > index->buckets )
+		index->stale = true;
+	else
+		indexInsert( index, array->type->hash( elementAt( array, position )), position );
+}
 
-	return checkArray( put( array, position, element ));
+//Remove the entry of the element at the position, the positions of the other elements stay the same.
+static void
+indexDrop( WArray* array, size_t position )
+{
+	truncatePrefixes( array, position );
+	WArrayIndex* index = array->index;
+	if ( not index or index->stale ) return;
+
+	IndexEntry* entries = index->entries;
+	size_t mask = index->buckets-1;
+	size_t stored = position + index->offset;
+	size_t hole = array->type->hash( elementAt( array, position )) & mask;
+	while ( not entries[hole].used or entries[hole].position != stored )
+		hole = (hole+1) & mask;
+
+	//Backward shift deletion: Move following entries into the hole unless it lies before their home bucket.
+	for ( size_t next = (hole+1) & mask; entries[next].used; next = (next+1) & mask ) {
+		size_t home = entries[next].hash & mask;
+		if ( ((next - home) & mask) >= ((next - hole) & mask) ) {
+			entries[hole] = entries[next];
+			hole = next;
+		}
+	}
+	entries[hole].used = false;
+	index->count--;
 }
 
-WArray*
-warray_insertSorted( WArray* array, const void* element )
+//Update the index after n elements were put at the position.
+static void
+indexInserted( WArray* array, size_t position, size_t n )
 {
-	assert( array );
-	assert( array->type->compare );
+	truncatePrefixes( array, position );
+	WArrayIndex* index = array->index;
+	if ( not index ) return;
 
-	WElementCompare* compare = array->type->compare;
-	void** data = array->data;
-    for ( size_t i = 0; i < array->size; i++ ) {
-        if ( compare( element, data[i] ) < 0 )
-			return warray_insert( array, i, element );
-    }
+	if ( position == 0 )
+		index->offset -= n;
+	else if ( position + n < array->size )
+		index->stale = true;
 
-	return warray_append( array, element );
+	for ( size_t i = 0; i < n; i++ )
+		indexAdd( array, position+i );
 }
 
-void
-__warray_pushAt( WArray* array, size_t position, void* element )
+//Update the index after n elements were overwritten from the position on, possibly behind the old end.
+static void
+indexSet( WArray* array, size_t position, size_t n, size_t oldSize )
 {
-	assert( array );
+	for ( size_t i = position; i < position+n and i < oldSize; i++ )
+		indexAdd( array, i );
 
-	resize( array, __wmax( array->size, position+1 ));
+	if ( array->size > oldSize )
+		indexInserted( array, oldSize, array->size-oldSize );
+}
 
-	if ( position < array->size ) {	//Delete the old element.
-		assert( &array->data[position] );
-		array->type->delete( &array->data[position] );
-	}
-	else {							//Fill the gap with zeroes.
-		memset( &array->data[array->size], 0, (position-array->size) * sizeof(void*));
-		array->size = position+1;
+//Update the index before the element at the position gets removed.
+static void
+indexRemove( WArray* array, size_t position )
+{
+	truncatePrefixes( array, position );
+	WArrayIndex* index = array->index;
+	if ( not index or index->stale ) return;
+
+	if ( position == 0 or position == array->size-1 )
+		indexDrop( array, position );
+	else
+		index->stale = true;
+
+	if ( position == 0 )
+		index->offset++;
+}
+
+//Return the first or last position of an element equal to the given one, -1 if there is none.
+static ssize_t
+indexLookup( const WArray* array, const void* element, bool last )
+{
+	WArrayIndex* index = array->index;
+	if ( index->stale )
+		rebuildIndex( array );
+
+	size_t hash = array->type->hash( element );
+	size_t mask = index->buckets-1;
+	ssize_t found = -1;
+	for ( size_t bucket = hash & mask; index->entries[bucket].used; bucket = (bucket+1) & mask ) {
+		if ( index->entries[bucket].hash != hash ) continue;
+
+		ssize_t position = index->entries[bucket].position - index->offset;
+		bool better = found < 0 or (last ? position > found : position < found);
+		if ( better and array->type->compare( element, elementAt( array, position )) == 0 )
+			found = position;
 	}
 
-	array->data[position] = element;
+	return found;
+}
 
-	assert( array );
-	checkArray( array );
+static void
+deleteIndex( WArrayIndex** indexPtr )
+{
+	if ( not *indexPtr ) return;
+
+	free( (*indexPtr)->entries );
+	free( *indexPtr );
+	*indexPtr = NULL;
 }
 
 //-------------------------------------------------------------------------------
+//	Vector scans
 //-------------------------------------------------------------------------------
 
+/*	Int and pointer elements are stored by value in the slots, so min, max, search, count and
+	compare can scan the slots as signed 64 bit integers instead of calling the comparison
+	function for every element. The scalar versions finish the tails of the vector versions.
+*/
 
-WArray*
-warray_append_n( WArray* array, size_t n, void* const elements[n] )
+static intptr_t
+scalarMin( void* const* data, size_t n, intptr_t minimum )
 {
-   	assert( array );
-	assert( n > 0 );
-	assert( elements );
-
 	for ( size_t i = 0; i < n; i++ )
-		warray_append( array, elements[i] );
-
-	assert( array );
-	return checkArray( array );
+		minimum = (intptr_t)data[i] < minimum ? (intptr_t)data[i] : minimum;
+	return minimum;
 }
 
-WArray*
-warray_prepend_n( WArray* array, size_t n, void* const elements[n] )
+static intptr_t
+scalarMax( void* const* data, size_t n, intptr_t maximum )
 {
-   	assert( array );
-	assert( n > 0 );
-	assert( elements );
-
-	assert( array );
-	return warray_insert_n( array, 0, n, elements );
+	for ( size_t i = 0; i < n; i++ )
+		maximum = (intptr_t)data[i] > maximum ? (intptr_t)data[i] : maximum;
+	return maximum;
 }
 
-WArray*
-warray_insert_n( WArray* array, size_t position, size_t n, void* const elements[n] )
+static size_t
+scalarCount( void* const* data, size_t n, const void* value )
 {
-   	assert( array );
-	assert( n > 0 );
-	assert( elements );
+	size_t count = 0;
+	for ( size_t i = 0; i < n; i++ )
+		count += data[i] == value;
+	return count;
+}
 
-  	for ( size_t i = 0; i < n; i++ )
-		warray_insert( array, position+i, elements[i] );
+//Position of the first slot with the value, n if there is none.
+static size_t
+scalarIndex( void* const* data, size_t n, const void* value )
+{
+	for ( size_t i = 0; i < n; i++ )
+		if ( data[i] == value ) return i;
+	return n;
+}
 
-	assert( array );
-	return checkArray( array );
+//Position of the last slot with the value, n if there is none.
+static size_t
+scalarRindex( void* const* data, size_t n, const void* value )
+{
+	for ( size_t i = n-1; i < n; i-- )
+		if ( data[i] == value ) return i;
+	return n;
 }
 
-WArray*
-warray_set_n( WArray* array, size_t position, size_t n, void* const elements[n] )
+//Position of the first differing slots, n if all are equal.
+static size_t
+scalarMismatch( void* const* data1, void* const* data2, size_t n )
 {
-   	assert( array );
-	assert( n > 0 );
-	assert( elements );
+	for ( size_t i = 0; i < n; i++ )
+		if ( data1[i] != data2[i] ) return i;
+	return n;
+}
 
-  	for ( size_t i = 0; i < n; i++ )
-		warray_set( array, position+i, elements[i] );
+#ifdef WARRAY_VECTOR_SCANS
 
-	assert( array );
-	return checkArray( array );
+/*	Generate the vector scans for an instruction set. Masks have one bit per lane, FULL is the
+	mask of all lanes. The loops work on two vectors at once to hide the instruction latencies.
+*/
+#define DEFINE_SCANS( name, TARGET, V, LANES, FULL, LOAD, SET1, EQ, GT, BLEND, SUB, MASK, STORE )	\
+static __attribute__(( target( TARGET ))) intptr_t													\
+name##_min( void* const* data, size_t n )															\
+{																									\
+	V min1 = SET1( INTPTR_MAX ), min2 = min1;														\
+	size_t i = 0;																					\
+	for ( ; i + 2*LANES <= n; i += 2*LANES ) {														\
+		V x1 = LOAD( data+i ), x2 = LOAD( data+i+LANES );											\
+		min1 = BLEND( min1, x1, GT( min1, x1 ));													\
+		min2 = BLEND( min2, x2, GT( min2, x2 ));													\
+	}																								\
+	intptr_t lanes[2*LANES];																		\
+	STORE( lanes, min1 );																			\
+	STORE( lanes+LANES, min2 );																		\
+	intptr_t minimum = scalarMin( data+i, n-i, INTPTR_MAX );										\
+	for ( size_t k = 0; k < 2*LANES; k++ )															\
+		minimum = lanes[k] < minimum ? lanes[k] : minimum;											\
+	return minimum;																					\
+}																									\
+																									\
+static __attribute__(( target( TARGET ))) intptr_t													\
+name##_max( void* const* data, size_t n )															\
+{																									\
+	V max1 = SET1( INTPTR_MIN ), max2 = max1;														\
+	size_t i = 0;																					\
+	for ( ; i + 2*LANES <= n; i += 2*LANES ) {														\
+		V x1 = LOAD( data+i ), x2 = LOAD( data+i+LANES );											\
+		max1 = BLEND( max1, x1, GT( x1, max1 ));													\
+		max2 = BLEND( max2, x2, GT( x2, max2 ));													\
+	}																								\
+	intptr_t lanes[2*LANES];																		\
+	STORE( lanes, max1 );																			\
+	STORE( lanes+LANES, max2 );																		\
+	intptr_t maximum = scalarMax( data+i, n-i, INTPTR_MIN );										\
+	for ( size_t k = 0; k < 2*LANES; k++ )															\
+		maximum = lanes[k] > maximum ? lanes[k] : maximum;											\
+	return maximum;																					\
+}																									\
+																									\
+/*Equal lanes are all ones, so subtracting them counts.*/											\
+static __attribute__(( target( TARGET ))) size_t													\
+name##_count( void* const* data, size_t n, const void* value )										\
+{																									\
+	V key = SET1( (intptr_t)value ), count1 = SET1( 0 ), count2 = count1;							\
+	size_t i = 0;																					\
+	for ( ; i + 2*LANES <= n; i += 2*LANES ) {														\
+		count1 = SUB( count1, EQ( LOAD( data+i ), key ));											\
+		count2 = SUB( count2, EQ( LOAD( data+i+LANES ), key ));										\
+	}																								\
+	intptr_t lanes[2*LANES];																		\
+	STORE( lanes, count1 );																			\
+	STORE( lanes+LANES, count2 );																	\
+	size_t count = scalarCount( data+i, n-i, value );												\
+	for ( size_t k = 0; k < 2*LANES; k++ )															\
+		count += lanes[k];																			\
+	return count;																					\
+}																									\
+																									\
+static __attribute__(( target( TARGET ))) size_t													\
+name##_index( void* const* data, size_t n, const void* value )										\
+{																									\
+	V key = SET1( (intptr_t)value );																\
+	size_t i = 0;																					\
+	for ( ; i + 2*LANES <= n; i += 2*LANES ) {														\
+		unsigned mask = MASK( EQ( LOAD( data+i ), key ))											\
+			| MASK( EQ( LOAD( data+i+LANES ), key )) << LANES;										\
+		if ( mask ) return i + __builtin_ctz( mask );												\
+	}																								\
+	return i + scalarIndex( data+i, n-i, value );													\
+}																									\
+																									\
+static __attribute__(( target( TARGET ))) size_t													\
+name##_rindex( void* const* data, size_t n, const void* value )										\
+{																									\
+	V key = SET1( (intptr_t)value );																\
+	size_t i = n;																					\
+	for ( ; i >= 2*LANES; i -= 2*LANES ) {															\
+		unsigned mask = MASK( EQ( LOAD( data+i-2*LANES ), key ))									\
+			| MASK( EQ( LOAD( data+i-LANES ), key )) << LANES;										\
+		if ( mask ) return i-2*LANES + 31 - __builtin_clz( mask );									\
+	}																								\
+	size_t position = scalarRindex( data, i, value );												\
+	return position < i ? position : n;																\
+}																									\
+																									\
+static __attribute__(( target( TARGET ))) size_t													\
+name##_mismatch( void* const* data1, void* const* data2, size_t n )									\
+{																									\
+	size_t i = 0;																					\
+	for ( ; i + 2*LANES <= n; i += 2*LANES ) {														\
+		unsigned mask = MASK( EQ( LOAD( data1+i ), LOAD( data2+i )))								\
+			| MASK( EQ( LOAD( data1+i+LANES ), LOAD( data2+i+LANES ))) << LANES;					\
+		if ( mask != FULL ) return i + __builtin_ctz( ~mask );										\
+	}																								\
+	return i + scalarMismatch( data1+i, data2+i, n-i );												\
 }
 
-//-------------------------------------------------------------------------------
-//-------------------------------------------------------------------------------
+#define AVX2_LOAD( address )		_mm256_loadu_si256( (const __m256i*)(address) )
+#define AVX2_STORE( address, x )	_mm256_storeu_si256( (__m256i*)(address), x )
+#define AVX2_MASK( x )				(unsigned)_mm256_movemask_pd( _mm256_castsi256_pd( x ))
+#define SSE4_LOAD( address )		_mm_loadu_si128( (const __m128i*)(address) )
+#define SSE4_STORE( address, x )	_mm_storeu_si128( (__m128i*)(address), x )
+#define SSE4_MASK( x )				(unsigned)_mm_movemask_pd( _mm_castsi128_pd( x ))
+
+DEFINE_SCANS( scanAvx2, "avx2", __m256i, 4, 0xffu, AVX2_LOAD, _mm256_set1_epi64x, _mm256_cmpeq_epi64,
+	_mm256_cmpgt_epi64, _mm256_blendv_epi8, _mm256_sub_epi64, AVX2_MASK, AVX2_STORE )
+DEFINE_SCANS( scanSse4, "sse4.2", __m128i, 2, 0xfu, SSE4_LOAD, _mm_set1_epi64x, _mm_cmpeq_epi64,
+	_mm_cmpgt_epi64, _mm_blendv_epi8, _mm_sub_epi64, SSE4_MASK, SSE4_STORE )
+
+//The best instruction set of the processor running the program.
+#define DISPATCH_SCAN( scan, ... )								\
+	if ( __builtin_cpu_supports( "avx2" ))						\
+		return scanAvx2_##scan( __VA_ARGS__ );					\
+	if ( __builtin_cpu_supports( "sse4.2" ))					\
+		return scanSse4_##scan( __VA_ARGS__ );
+
+#else
+#define DISPATCH_SCAN( scan, ... )
+#endif
+
+static intptr_t
+scanMin( void* const* data, size_t n )
+{
+	DISPATCH_SCAN( min, data, n )
+	return scalarMin( data, n, INTPTR_MAX );
+}
 
-const void*
-warray_at( const WArray* array, size_t index )
+static intptr_t
+scanMax( void* const* data, size_t n )
 {
-	assert( array );
-	assert( index < array->size && "Array access out of bounds." );
+	DISPATCH_SCAN( max, data, n )
+	return scalarMax( data, n, INTPTR_MIN );
+}
 
-	return array->data[index];
+static size_t
+scanCount( void* const* data, size_t n, const void* value )
+{
+	DISPATCH_SCAN( count, data, n, value )
+	return scalarCount( data, n, value );
 }
 
-const void*
-warray_first( const WArray* array )
+static size_t
+scanIndex( void* const* data, size_t n, const void* value )
 {
-	assert( array );
-	assert( warray_nonEmpty( array ));
+	DISPATCH_SCAN( index, data, n, value )
+	return scalarIndex( data, n, value );
+}
 
-	return warray_at( array, 0 );
+static size_t
+scanRindex( void* const* data, size_t n, const void* value )
+{
+	DISPATCH_SCAN( rindex, data, n, value )
+	return scalarRindex( data, n, value );
 }
 
-const void*
-warray_last( const WArray* array )
+static size_t
+scanMismatch( void* const* data1, void* const* data2, size_t n )
 {
-	assert( array );
-	assert( warray_nonEmpty( array ));
+	DISPATCH_SCAN( mismatch, data1, data2, n )
+	return scalarMismatch( data1, data2, n );
+}
 
-	return warray_at( array, array->size-1 );
+//True if the elements are ints or pointers stored in the slots and ordered by their value.
+static inline bool
+hasScalarSlots( const WArray* array )
+{
+	WElementCompare* compare = array->type->compare;
+	return not array->elementSize and (compare == wtypeInt_compare or compare == wtypePtr_compare);
 }
 
-const void*
-warray_sample( const WArray* array )
+//-------------------------------------------------------------------------------
+//	Sorting helpers
+//-------------------------------------------------------------------------------
+
+enum {
+	SortInsertionLimit = 24,	//Smaller ranges are sorted by insertion sort.
+	SortNintherLimit = 128,		//Larger ranges take the pivot as median of three medians.
+	SortPartialLimit = 8		//Moves allowed before a partial insertion sort gives up.
+};
+
+static bool
+isSortedBy( const WArray* array, WElementCompare* compare )
 {
-	assert( array );
-	assert( warray_nonEmpty( array ));
+	if ( not array->size ) return true;
 
-	return warray_at( array, rand() % array->size );
+	for ( size_t j = 0; j < array->size-1; j++ ) {
+		if ( compare( warray_at( array, j ), warray_at( array, j+1 )) > 0 )
+			return false;
+	}
+
+	return true;
 }
 
-void*
-warray_cloneAt( const WArray* array, size_t position )
+static bool
+isSorted( const WArray* array )
+{
+	return isSortedBy( array, array->type->compare );
+}
+
+//Compares the things at two positions, e.g. array elements or cached keys.
+typedef int PositionCompare( const void* context, size_t position1, size_t position2 );
+
+//Stable merge sort of positions, so equal things keep their original order.
+static void
+mergeSortPositions( size_t positions[], size_t buffer[], size_t n, PositionCompare* compare, const void* context )
+{
+	if ( n < SortInsertionLimit ) {
+		for ( size_t i = 1; i < n; i++ ) {
+			size_t position = positions[i];
+			size_t j = i;
+			for ( ; j > 0 and compare( context, position, positions[j-1] ) < 0; j-- )
+				positions[j] = positions[j-1];
+			positions[j] = position;
+		}
+		return;
+	}
+
+	size_t half = n/2;
+	mergeSortPositions( positions, buffer, half, compare, context );
+	mergeSortPositions( positions+half, buffer, n-half, compare, context );
+	if ( compare( context, positions[half], positions[half-1] ) >= 0 ) return;	//In order already
+
+	memcpy( buffer, positions, half * sizeof( size_t ));
+	size_t left = 0, right = half, write = 0;
+	while ( left < half and right < n ) {
+		if ( compare( context, positions[right], buffer[left] ) < 0 )
+			positions[write++] = positions[right++];
+		else
+			positions[write++] = buffer[left++];
+	}
+	while ( left < half )
+		positions[write++] = buffer[left++];
+}
+
+static int
+compareElements( const void* array, size_t position1, size_t position2 )
+{
+	return ((const WArray*)array)->type->compare( elementAt( array, position1 ), elementAt( array, position2 ));
+}
+
+//Sort the positions by their elements, so equal elements keep their original order.
+static void
+sortPositions( const WArray* array, size_t positions[], size_t buffer[], size_t n )
+{
+	mergeSortPositions( positions, buffer, n, compareElements, array );
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+const WType* wtypeArray = &(WType){
+	.clone = (WElementClone*)warray_clone,
+	.delete = (WElementDelete*)warray_delete,
+	.compare = (WElementCompare*)warray_compare,
+	.fromString = (WElementFromString*)warray_fromString,
+	.toString = (WElementToString*)warray_toString
+};
+
+enum ArrayParameters {
+	ArrayDefaultCapacity 	= 8,
+	ArrayGrowthRate 		= 2,
+	ArrayEmbeddedBytes		= 64,	//Data blocks up to this size share the allocation of the header
+};
+
+//The start of the data block, the elements begin front slots later.
+static inline char*
+blockOf( const WArray* array )
+{
+	return (char*)array->data - array->front * slotSize( array );
+}
+
+//Whether the data block lives in the header allocation.
+static inline bool
+isEmbedded( const WArray* array )
+{
+	return blockOf( array ) == (char*)array->embedded;
+}
+
+/*	The elements occupy a contiguous run inside the data block, which may start after some free
+	front slots. So elements can be added and removed at both ends without moving the others.
+*/
+
+/*	Move the elements, so that newFront free slots precede them and newCapacity slots follow
+	from the first element on. The block is only reallocated if it is too small.
+*/
+static void
+relocate( WArray* array, size_t newFront, size_t newCapacity )
+{
+	assert( newCapacity >= array->size );
+
+	size_t slot = slotSize( array );
+	size_t total = array->front + array->capacity;
+	char* block = blockOf( array );
+
+	if ( newFront + newCapacity <= total ) {	//Slide inside the block.
+		newCapacity = total - newFront;
+		memmove( block + newFront * slot, array->data, array->size * slot );
+	}
+	else if ( isEmbedded( array )) {			//Spill the small block to the heap.
+		block = wallocator_alloc( array->allocator, (newFront + newCapacity) * slot );
+		memcpy( block + newFront * slot, array->data, array->size * slot );
+	}
+	else {
+		block = wallocator_realloc( array->allocator, block, total * slot, (newFront + newCapacity) * slot );
+		if ( newFront != array->front )
+			memmove( block + newFront * slot, block + array->front * slot, array->size * slot );
+	}
+
+	array->data = (void**)(block + newFront * slot);
+	array->front = newFront;
+	array->capacity = newCapacity;
+}
+
+//Resize the array if necessary, so that it can take the new size.
+static void
+resize( WArray* array, size_t newSize )
+{
+	if ( newSize <= array->capacity ) return;
+
+	if ( array->front >= array->size and newSize <= array->front + array->capacity )
+		relocate( array, 0, newSize );		//Reuse the slots freed at the front, like queues do.
+	else
+		relocate( array, array->front, __wmax( newSize, array->capacity * ArrayGrowthRate ));
+
+	assert( array->capacity >= newSize );
+	checkArray( array );
+}
+
+//Make sure there are at least n free slots before the first element.
+static void
+resizeFront( WArray* array, size_t n )
+{
+	if ( n <= array->front ) return;
+
+	size_t total = array->front + array->capacity;
+	size_t newFront = n + array->size / 2;
+	size_t rest = total > newFront ? total - newFront : 0;
+	relocate( array, newFront, __wmax( array->size, rest ));
+
+	assert( array->front >= n );
+}
+
+//Let an empty array start at the beginning of its block again.
+static void
+recenter( WArray* array )
+{
+	assert( not array->size );
+
+	array->data = (void**)blockOf( array );
+	array->capacity += array->front;
+	array->front = 0;
+}
+
+//Make room for n new slots at the position by moving the smaller part of the elements once.
+static void
+openGap( WArray* array, size_t position, size_t n )
+{
+	assert( position <= array->size );
+
+	if ( position < (array->size+1) / 2 ) {
+		resizeFront( array, n );
+		array->data = (void**)((char*)array->data - n * slotSize( array ));
+		array->front -= n;
+		array->capacity += n;
+		moveSlots( array, 0, n, position );
+	}
+	else {
+		resize( array, array->size+n );
+		moveSlots( array, position+n, position, array->size-position );
+	}
+}
+
+//Copy n elements of the source array into the slots from position on, inline elements in one go.
+static void
+copyRun( WArray* array, size_t position, const WArray* source, size_t start, size_t n )
+{
+	assert( array->elementSize == source->elementSize );
+	assert( position + n <= array->capacity );
+
+	if ( array->elementSize )
+		memcpy( slotAt( array, position ), slotAt( source, start ), n * array->elementSize );
+	else for ( size_t i = 0; i < n; i++ )
+		storeAt( array, position+i, source->data[start+i] );
+}
+
+//Close the slot at the position by moving the smaller part of the elements.
+static void
+closeGap( WArray* array, size_t position )
 {
-	assert( array );
-	assert( array->type );
-	assert( array->type->clone );
 	assert( position < array->size );
 
-	if ( array->data[position] )
-		return array->type->clone( array->data[position] );
+	if ( position < array->size / 2 ) {
+		moveSlots( array, 1, 0, position );
+		array->data = (void**)slotAt( array, 1 );
+		array->front++;
+		array->capacity--;
+	}
 	else
-		return NULL;
+		moveSlots( array, position, position+1, array->size-position-1 );
+
+	array->size--;
+	if ( not array->size )
+		recenter( array );
 }
 
-void*
-warray_cloneFirst( const WArray* array )
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+//Default type of inline arrays: The elements are plain bytes without any comparison method.
+static const WType inlineType = {
+	.clone = wtypePtr_clone,
+	.delete = wtypePtr_delete,
+};
+
+static WArray*
+newArray( size_t capacity, size_t elementSize, const WType* type, const WAllocator* allocator )
 {
+	if ( not capacity ) capacity = ArrayDefaultCapacity;
+	size_t bytes = capacity * (elementSize ? elementSize : sizeof( void* ));
+	bool embedded = bytes <= ArrayEmbeddedBytes;
+
+	WArray* array = wallocator_alloc( allocator, sizeof( WArray ) + (embedded ? bytes : 0));
+	*array = (WArray){
+		.capacity		= capacity,
+		.type			= type,
+		.elementSize	= elementSize,
+		.allocator		= allocator,
+	};
+	array->data = embedded ? (void**)array->embedded : wallocator_alloc( allocator, bytes );
+	if ( type->arena and not elementSize )
+		array->arena = warena_new( allocator );
+
 	assert( array );
-	assert( warray_nonEmpty( array ));
+	return array;
+}
 
-	return warray_cloneAt( array, 0 );
+WArray*
+warray_new( size_t capacity, const WType* type )
+{
+	return warray_newWithAllocator( capacity, type, wallocatorDefault );
 }
 
-void*
-warray_cloneLast( const WArray* array )
+WArray*
+warray_newWithAllocator( size_t capacity, const WType* type, const WAllocator* allocator )
 {
+	assert( not type or type->clone );
+	assert( not type or type->delete );
+	assert( not type or not type->cloneWith or type->deleteWith );
+	assert( not type or not type->arena or type->cloneWith );
+	assert( allocator );
+	assert( allocator->alloc and allocator->realloc and allocator->free );
+
+	WArray* array = newArray( capacity, 0, type ? type : wtypePtr, allocator );
+
 	assert( array );
-	assert( warray_nonEmpty( array ));
+	assert( array->allocator == allocator );
+	return checkArray( array );
+}
 
-	return warray_cloneAt( array, array->size-1 );
+WArray*
+warray_newInline( size_t capacity, size_t elementSize, const WType* type )
+{
+	assert( elementSize > 0 );
+
+	WArray* array = newArray( capacity, elementSize, type ? type : &inlineType, wallocatorDefault );
+
+	assert( array );
+	assert( array->elementSize == elementSize );
+	return checkArray( array );
 }
 
 WArray*
-warray_slice( const WArray* array, size_t start, size_t end )
+warray_clone( const WArray* array )
 {
 	assert( array );
-	assert( start <= end );
-	assert( end < array->size );
 
-	size_t size = end-start+1;
-    WArray* slice = warray_new( size, array->type );
-	warray_append_n( slice, size, &array->data[start] );
+	WArray *copy = newArray( array->capacity, array->elementSize, array->type, array->allocator );
+	copy->size = array->size;
 
-	assert( slice );
-	assert( slice->size == end-start+1 );
-	return checkArray( slice );
+	if ( array->elementSize )
+		memcpy( copy->data, array->data, array->size * array->elementSize );
+	else for ( size_t i = 0; i < array->size; i++ )
+		storeAt( copy, i, array->data[i] );
+
+	assert( copy );
+	assert( not array->type->compare or warray_equal( array, copy ));
+	return checkArray( copy );
 }
 
-void*
-warray_stealAt( WArray* array, size_t position )
+void
+warray_delete( WArray** arrayPtr )
+{
+	if ( not arrayPtr ) return;
+
+	WArray* array = *arrayPtr;
+
+	warray_clear( array );
+	deleteIndex( &array->index );
+	deletePrefixes( &array->prefixes );
+	warena_delete( &array->arena );
+	if ( not isEmbedded( array ))
+		wallocator_free( array->allocator, blockOf( array ));
+	wallocator_free( array->allocator, array );
+	*arrayPtr = NULL;
+}
+
+WArray*
+warray_clear( WArray* array )
+{
+	if ( not array ) return array;
+
+	if ( array->arena )		//Release all elements at once.
+		warena_reset( array->arena );
+	else for ( size_t i = 0; i < array->size; i++ )
+		deleteAt( array, i );
+
+	array->size = 0;
+	recenter( array );
+	invalidateIndex( array );
+
+	assert( array );
+	assert( warray_empty( array ));
+	return checkArray( array );
+}
+
+void
+warray_assign( WArray** arrayPointer, WArray* other )
+{
+	if ( not arrayPointer ) return;
+	WArray* array = *arrayPointer;
+
+	assert( array->type == other->type && "Can only assign arrays of the same type." );
+
+	warray_delete( arrayPointer );
+	*arrayPointer = other;
+
+	checkArray( *arrayPointer );
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+static WArray*
+put( WArray* array, size_t position, const void* element )
 {
 	assert( array );
-	assert( position < array->size && "Array access out of bounds." );
+	assert( position < array->capacity );
+
+	storeAt( array, position, element );
+	array->size = __wmax( array->size+1, position+1 );
+
+	assert( array );
+	assert( array->size > position );
+	assert( array->capacity > position );
+	return checkArray( array );
+}
 
-	void* value = array->data[position];
+WArray*
+warray_append( WArray* array, const void* element )
+{
+	assert( array );
 
-	if ( position < array->size-1 )
-		memmove( &array->data[position], &array->data[position+1], (array->size-position-1) * sizeof(void*));
+	resize( array, array->size+1 );
+	put( array, array->size, element );
+	indexAdd( array, array->size-1 );
 
-	array->size--;
+	return checkArray( array );
+}
 
-	return value;
+WArray*
+warray_prepend( WArray* array, const void* element )
+{
+	assert( array );
+
+	openGap( array, 0, 1 );
+	put( array, 0, element );
+	indexInserted( array, 0, 1 );
+
+	return checkArray( array );
 }
 
-void*
-warray_stealFirst( WArray* array )
+WArray*
+warray_set( WArray* array, size_t position, const void* element )
+{
+	assert( array );
+
+	size_t oldSize = array->size;
+	resize( array, __wmax( array->size, position+1 ));
+
+	if ( position < array->size ) {	//Delete the old element.
+		indexDrop( array, position );
+		deleteAt( array, position );
+	}
+	else {							//Fill the gap with zeroes.
+		zeroSlots( array, array->size, position-array->size );
+		array->size = position+1;
+	}
+
+	storeAt( array, position, element );
+	indexSet( array, position, 1, oldSize );
+
+	assert( array );
+	return checkArray( array );
+}
+
+WArray*
+warray_insert( WArray* array, size_t position, const void* element )
+{
+	assert( array );
+
+	size_t oldSize = array->size;
+	if ( position <= array->size )	//Make room for the new element.
+		openGap( array, position, 1 );
+	else {							//Fill the gap with zeros.
+		resize( array, position+1 );
+		zeroSlots( array, array->size, position-array->size );
+	}
+
+	put( array, position, element );
+	indexInserted( array, __wmin( position, oldSize ), array->size-oldSize );
+
+	return checkArray( array );
+}
+
+//Return the position behind the last element not greater than the given one in a sorted array.
+static size_t
+upperBound( const WArray* array, const void* element )
+{
+	WElementCompare* compare = array->type->compare;
+
+	size_t low = 0, high = array->size;
+	while ( low < high ) {
+		size_t middle = low + (high-low)/2;
+		if ( compare( element, elementAt( array, middle )) < 0 )
+			high = middle;
+		else
+			low = middle+1;
+	}
+
+	return low;
+}
+
+WArray*
+warray_insertSorted( WArray* array, const void* element )
+{
+	assert( array );
+	assert( array->type->compare );
+
+	return warray_insert( array, upperBound( array, element ), element );
+}
+
+//Store an element, either copied with the clone() method or taken over if adopt is true.
+static void
+putElement( WArray* array, size_t position, void* element, bool adopt )
+{
+	if ( not adopt )
+		storeAt( array, position, element );
+	else if ( array->elementSize ) {	//Inline arrays keep a copy of the bytes only.
+		storeAt( array, position, element );
+		free( element );
+	}
+	else
+		array->data[position] = adoptElement( array, element );
+}
+
+//Insert n elements at the position, a gap behind the last element is filled with zeros.
+static void
+insertElements( WArray* array, size_t position, size_t n, void* const elements[n], bool adopt )
+{
+	size_t oldSize = array->size;
+	if ( position <= array->size )	//Make room for the new elements.
+		openGap( array, position, n );
+	else {							//Fill the gap with zeros.
+		resize( array, position+n );
+		zeroSlots( array, array->size, position-array->size );
+	}
+
+	for ( size_t i = 0; i < n; i++ )
+		putElement( array, position+i, elements[i], adopt );
+	array->size = __wmax( array->size, position ) + n;
+	indexInserted( array, __wmin( position, oldSize ), array->size-oldSize );
+}
+
+//Replace or add n elements from the position on, a gap behind the last element is filled with zeros.
+static void
+setElements( WArray* array, size_t position, size_t n, void* const elements[n], bool adopt )
+{
+	size_t oldSize = array->size;
+	resize( array, __wmax( array->size, position+n ));
+
+	if ( position > array->size )	//Fill the gap with zeroes.
+		zeroSlots( array, array->size, position-array->size );
+
+	for ( size_t i = 0; i < n; i++ ) {
+		if ( position+i < array->size ) {	//Delete the old element.
+			indexDrop( array, position+i );
+			deleteAt( array, position+i );
+		}
+		putElement( array, position+i, elements[i], adopt );
+	}
+	array->size = __wmax( array->size, position+n );
+	indexSet( array, position, n, oldSize );
+}
+
+void
+__warray_pushAt( WArray* array, size_t position, void* element )
+{
+	assert( array );
+
+	insertElements( array, position, 1, &element, true );
+
+	assert( array );
+	checkArray( array );
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+
+WArray*
+warray_append_n( WArray* array, size_t n, void* const elements[n] )
+{
+   	assert( array );
+	assert( n > 0 );
+	assert( elements );
+
+	assert( array );
+	return warray_insert_n( array, array->size, n, elements );
+}
+
+WArray*
+warray_prepend_n( WArray* array, size_t n, void* const elements[n] )
+{
+   	assert( array );
+	assert( n > 0 );
+	assert( elements );
+
+	assert( array );
+	return warray_insert_n( array, 0, n, elements );
+}
+
+WArray*
+warray_insert_n( WArray* array, size_t position, size_t n, void* const elements[n] )
+{
+   	assert( array );
+	assert( n > 0 );
+	assert( elements );
+
+	insertElements( array, position, n, elements, false );
+
+	assert( array );
+	return checkArray( array );
+}
+
+WArray*
+warray_pushInsert_n( WArray* array, size_t position, size_t n, void* elements[n] )
+{
+   	assert( array );
+	assert( n > 0 );
+	assert( elements );
+
+	insertElements( array, position, n, elements, true );
+	memset( elements, 0, n * sizeof( void* ));
+
+	assert( array );
+	return checkArray( array );
+}
+
+WArray*
+warray_insertSortedMany( WArray* array, size_t n, void* const elements[n] )
+{
+   	assert( array );
+	assert( array->type->compare );
+	assert( n > 0 );
+	assert( elements );
+
+	//Clone the new elements behind the old ones and sort their positions.
+	size_t oldSize = array->size;
+	resize( array, oldSize+n );
+	for ( size_t i = 0; i < n; i++ )
+		storeAt( array, oldSize+i, elements[i] );
+	array->size = oldSize+n;
+
+	size_t* positions = __wxmalloc( n * sizeof( size_t ));
+	size_t* buffer = __wxmalloc( n * sizeof( size_t ));
+	for ( size_t i = 0; i < n; i++ )
+		positions[i] = oldSize+i;
+	sortPositions( array, positions, buffer, n );
+
+	//Move the new elements out of the way in sorted order.
+	size_t slot = slotSize( array );
+	char* sorted = __wxmalloc( n * slot );
+	for ( size_t i = 0; i < n; i++ )
+		memcpy( sorted + i*slot, slotAt( array, positions[i] ), slot );
+
+	//Merge from the back, new elements go behind equal old ones.
+	WElementCompare* compare = array->type->compare;
+	size_t old = oldSize, added = n, write = oldSize+n;
+	while ( added > 0 ) {
+		char* addedSlot = sorted + (added-1) * slot;
+		const void* addedElement = array->elementSize ? addedSlot : *(void**)addedSlot;
+		if ( old > 0 and compare( addedElement, elementAt( array, old-1 )) < 0 )
+			copySlot( array, --write, --old );
+		else {
+			memcpy( slotAt( array, --write ), addedSlot, slot );
+			added--;
+		}
+	}
+
+	free( sorted );
+	free( positions );
+	free( buffer );
+	invalidateIndex( array );
+
+	assert( array );
+	assert( isSorted( array ));
+	return checkArray( array );
+}
+
+WArray*
+warray_set_n( WArray* array, size_t position, size_t n, void* const elements[n] )
+{
+   	assert( array );
+	assert( n > 0 );
+	assert( elements );
+
+	setElements( array, position, n, elements, false );
+
+	assert( array );
+	return checkArray( array );
+}
+
+WArray*
+warray_pushSet_n( WArray* array, size_t position, size_t n, void* elements[n] )
+{
+   	assert( array );
+	assert( n > 0 );
+	assert( elements );
+
+	setElements( array, position, n, elements, true );
+	memset( elements, 0, n * sizeof( void* ));
+
+	assert( array );
+	return checkArray( array );
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+const void*
+warray_at( const WArray* array, size_t index )
+{
+	assert( array );
+	assert( index < array->size && "Array access out of bounds." );
+
+	return elementAt( array, index );
+}
+
+const void*
+warray_first( const WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_at( array, 0 );
+}
+
+const void*
+warray_last( const WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_at( array, array->size-1 );
+}
+
+const void*
+warray_sample( const WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_at( array, rand() % array->size );
+}
+
+void*
+warray_cloneAt( const WArray* array, size_t position )
+{
+	assert( array );
+	assert( array->type );
+	assert( array->elementSize or array->type->clone );	//Inline elements are copied bytewise.
+	assert( position < array->size );
+
+	return copyAt( array, position );
+}
+
+void*
+warray_cloneFirst( const WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_cloneAt( array, 0 );
+}
+
+void*
+warray_cloneLast( const WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_cloneAt( array, array->size-1 );
+}
+
+WArray*
+warray_slice( const WArray* array, size_t start, size_t end )
+{
+	assert( array );
+	assert( start <= end );
+	assert( end < array->size );
+
+	size_t size = end-start+1;
+    WArray* slice = newArray( size, array->elementSize, array->type, array->allocator );
+	copyRun( slice, 0, array, start, size );
+	slice->size = size;
+
+	assert( slice );
+	assert( slice->size == end-start+1 );
+	return checkArray( slice );
+}
+
+void*
+warray_stealAt( WArray* array, size_t position )
+{
+	assert( array );
+	assert( position < array->size && "Array access out of bounds." );
+
+	indexRemove( array, position );
+	void* value = releaseAt( array, position );
+	closeGap( array, position );
+
+	return value;
+}
+
+void*
+warray_stealFirst( WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_stealAt( array, 0 );
+}
+
+void*
+warray_stealLast( WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_stealAt( array, array->size-1 );
+}
+
+void*
+warray_stealSample( WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_stealAt( array, rand() % array->size );
+}
+
+WArray*
+warray_removeAt( WArray* array, size_t position )
+{
+	assert( array );
+	assert( position < warray_size( array ));
+
+	indexRemove( array, position );
+	deleteAt( array, position );
+	closeGap( array, position );
+
+	assert( array );
+	return checkArray( array );
+}
+
+WArray*
+warray_removeFirst( WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_removeAt( array, 0 );
+}
+
+WArray*
+warray_removeLast( WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+
+	return warray_removeAt( array, array->size-1 );
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+void
+warray_foreach( const WArray* array, WElementForeach* foreach, void* foreachData )
+{
+	assert( array );
+	assert( foreach );
+
+	for ( size_t i = 0; i < array->size; i++ )
+		foreach( elementAt( array, i ), foreachData );
+}
+
+void
+warray_foreachIndex( const WArray* array, WElementForeachIndex* foreach, void* foreachData )
+{
+	assert( array );
+	assert( foreach );
+
+	for ( size_t i = 0; i < array->size; i++ )
+		foreach( elementAt( array, i ), i, foreachData );
+}
+
+WArray*
+warray_filter( const WArray* array, WElementCondition* filter, const void* filterData )
+{
+	assert( array );
+	assert( filter );
+
+	WArray* filtered = newArray( array->capacity, array->elementSize, array->type, array->allocator );
+
+    for ( size_t i = 0; i < array->size; i++ ) {
+		void* element = elementAt( array, i );
+        if ( filter( element, filterData ))
+			storeAt( filtered, filtered->size++, element );
+    }
+
+	assert( filtered );
+	assert( warray_size( filtered ) <= warray_size( array ));
+	assert( warray_all( filtered, filter, filterData ));
+	return checkArray( filtered );
+}
+
+WArray*
+warray_reject( const WArray* array, WElementCondition* reject, const void* rejectData )
+{
+	assert( array );
+	assert( reject );
+
+	WArray* rejected = newArray( array->capacity, array->elementSize, array->type, array->allocator );
+
+    for ( size_t i = 0; i < array->size; i++ ) {
+		void* element = elementAt( array, i );
+        if ( not reject( element, rejectData ))
+			storeAt( rejected, rejected->size++, element );
+    }
+
+	assert( rejected );
+	assert( warray_size( rejected ) <= warray_size( array ));
+	assert( warray_none( rejected, reject, rejectData ));
+	return checkArray( rejected );
+}
+
+WArray*
+warray_select( WArray* array, WElementCondition* filter, const void* filterData )
+{
+	assert( array );
+	assert( filter );
+
+	size_t to = 0;
+    for ( size_t from = 0; from < array->size; from++ ) {
+        if ( filter( elementAt( array, from ), filterData ))
+			copySlot( array, to++, from );
+		else
+			deleteAt( array, from );
+    }
+
+    array->size = to;
+	invalidateIndex( array );
+
+	assert( array );
+	assert( warray_all( array, filter, filterData ));
+	return checkArray( array );
+}
+
+WArray*
+warray_unselect( WArray* array, WElementCondition* filter, const void* filterData )
+{
+	assert( array );
+	assert( filter );
+
+	size_t to = 0;
+    for ( size_t from = 0; from < array->size; from++ ) {
+        if ( !filter( elementAt( array, from ), filterData ))
+			copySlot( array, to++, from );
+		else
+			deleteAt( array, from );
+	}
+
+    array->size = to;
+	invalidateIndex( array );
+
+	assert( array );
+	assert( warray_none( array, filter, filterData ));
+	return checkArray( array );
+}
+
+WArray*
+warray_map( const WArray* array, WElementMap* map, const void* mapData, const WType* type )
+{
+	assert( array );
+	assert( map );
+
+	if ( not type ) type = wtypePtr;
+	WArray* mapped = warray_new( array->capacity, type );
+
+	for ( size_t i = 0; i < array->size; i++ )
+		mapped->data[i] = adoptElement( mapped, map( elementAt( array, i ), mapData ));
+
+    mapped->size = array->size;
+
+	assert( mapped );
+	assert( mapped->size == array->size );
+	assert( not type or mapped->type == type );
+    return checkArray( mapped );
+}
+
+void*
+warray_reduce( const WArray* array, WElementReduce* reduce, const void* startValue, const WType* type )
+{
+	assert( array );
+	assert( reduce );
+
+	if ( not type ) type = wtypePtr;
+
+	if ( array->size == 0 ) {
+		if ( startValue )
+			return type->clone( startValue );
+		else
+			return NULL;
+	}
+
+	void* reduction = reduce( elementAt( array, 0 ), startValue );
+
+    for ( size_t i = 1; i < array->size; i++ ) {
+		void* newReduction = reduce( elementAt( array, i ), reduction );
+		assert( &reduction );
+		type->delete( &reduction );
+		reduction = newReduction;
+	}
+
+	return reduction;
+}
+
+void*
+warray_fold( const WArray* array, WElementFold* fold, void* accumulator, const void* foldData )
+{
+	assert( array );
+	assert( fold );
+
+	for ( size_t i = 0; i < array->size; i++ )
+		fold( elementAt( array, i ), accumulator, foldData );
+
+	return accumulator;
+}
+
+//-------------------------------------------------------------------------------
+//	Parallel iteration
+//-------------------------------------------------------------------------------
+
+enum {
+	ParallelChunksPerThread = 4,	//More chunks than threads even out uneven callback costs.
+	ParallelChunkMinimum = 64,		//Elements per chunk worth the scheduling.
+	ReduceChunkSize = 256			//Fixed, so reductions don't depend on the thread count.
+};
+
+//The elements [begin, end) of an array processed by one pool task.
+typedef struct ChunkTask {
+	const WArray* array;
+	WArray* target;
+	size_t begin, end;
+	size_t count;			//Elements kept by a filter, later the position of the first one.
+	bool* keep;
+	bool expected;			//Condition result of the kept elements
+	WElementCondition* condition;
+	WElementMap* map;
+	WElementReduce* reduce;
+	const void* data;
+	void* result;
+} ChunkTask;
+
+//Split the array into chunks of at least the given size, ParallelChunksPerThread per thread.
+static ChunkTask*
+newChunks( const WArray* array, size_t threads, size_t minimum, size_t* count, ChunkTask pattern )
+{
+	if ( not threads ) threads = wpool_threads( wpool_default() );
+	size_t chunks = __wmax( __wmin( threads * ParallelChunksPerThread, array->size / minimum ), 1 );
+
+	ChunkTask* tasks = __wxmalloc( chunks * sizeof( ChunkTask ));
+	for ( size_t i = 0; i < chunks; i++ ) {
+		tasks[i] = pattern;
+		tasks[i].array = array;
+		tasks[i].begin = array->size / chunks * i + __wmin( i, array->size % chunks );
+		tasks[i].end = array->size / chunks * (i+1) + __wmin( i+1, array->size % chunks );
+	}
+	*count = chunks;
+	return tasks;
+}
+
+//Every lane of a parallel iteration runs the chunks first, first+stride, first+2*stride, ...
+typedef struct ChunkLane {
+	WTask* function;
+	ChunkTask* tasks;
+	size_t first, count, stride;
+} ChunkLane;
+
+static void
+runLane( void* argument )
+{
+	ChunkLane* lane = argument;
+	for ( size_t i = lane->first; i < lane->count; i += lane->stride )
+		lane->function( &lane->tasks[i] );
+}
+
+/*	Run the chunk tasks as at most threads lanes in the default pool, so no more threads work
+	on them at once. A single lane runs in the calling thread.
+*/
+static void
+runChunks( WTask* function, ChunkTask* tasks, size_t count, size_t threads )
+{
+	if ( not threads ) threads = wpool_threads( wpool_default() );
+	size_t lanes = __wmin( threads, count );
+	if ( lanes < 2 ) {
+		for ( size_t i = 0; i < count; i++ )
+			function( &tasks[i] );
+		return;
+	}
+
+	ChunkLane* lane = __wxmalloc( lanes * sizeof( ChunkLane ));
+	for ( size_t i = 0; i < lanes; i++ )
+		lane[i] = (ChunkLane){ function, tasks, i, count, lanes };
+	wpool_run( wpool_default(), runLane, lane, lanes, sizeof( ChunkLane ));
+	free( lane );
+}
+
+static void
+filterChunk( void* argument )
+{
+	ChunkTask* task = argument;
+	for ( size_t i = task->begin; i < task->end; i++ ) {
+		task->keep[i] = task->condition( elementAt( task->array, i ), task->data ) == task->expected;
+		task->count += task->keep[i];
+	}
+}
+
+static void
+storeChunk( void* argument )
+{
+	ChunkTask* task = argument;
+	size_t to = task->count;
+	for ( size_t i = task->begin; i < task->end; i++ )
+		if ( task->keep[i] )
+			storeAt( task->target, to++, elementAt( task->array, i ));
+}
+
+static void
+mapChunk( void* argument )
+{
+	ChunkTask* task = argument;
+	for ( size_t i = task->begin; i < task->end; i++ )
+		task->target->data[i] = task->map( elementAt( task->array, i ), task->data );
+}
+
+static void
+reduceChunk( void* argument )
+{
+	ChunkTask* task = argument;
+	const WType* type = task->target->type;
+	void* reduction = task->reduce( elementAt( task->array, task->begin ), task->data );
+	for ( size_t i = task->begin+1; i < task->end; i++ ) {
+		void* newReduction = task->reduce( elementAt( task->array, i ), reduction );
+		type->delete( &reduction );
+		reduction = newReduction;
+	}
+	task->result = reduction;
+}
+
+/*	Evaluate the condition of all chunks in parallel, then turn the kept counts into positions
+	by a prefix sum and store the kept elements of every chunk there. Elements are only cloned
+	in parallel with the default allocator, others need not be thread safe.
+*/
+static WArray*
+filterParallel( const WArray* array, WElementCondition* condition, const void* conditionData, bool expected, size_t threads )
+{
+	WArray* filtered = newArray( array->capacity, array->elementSize, array->type, array->allocator );
+
+	size_t count;
+	ChunkTask* tasks = newChunks( array, threads, ParallelChunkMinimum, &count, (ChunkTask){
+		.target = filtered, .keep = __wxmalloc( __wmax( array->size, 1 ) * sizeof( bool )),
+		.expected = expected, .condition = condition, .data = conditionData });
+	runChunks( filterChunk, tasks, count, threads );
+
+	for ( size_t i = 0; i < count; i++ ) {
+		size_t kept = tasks[i].count;
+		tasks[i].count = filtered->size;
+		filtered->size += kept;
+	}
+	bool parallel = array->elementSize or elementAllocator( filtered ) == wallocatorDefault;
+	runChunks( storeChunk, tasks, count, parallel ? threads : 1 );
+
+	free( tasks[0].keep );
+	free( tasks );
+	return filtered;
+}
+
+WArray*
+warray_filterParallel( const WArray* array, WElementCondition* filter, const void* filterData, size_t threads )
+{
+	assert( array );
+	assert( filter );
+
+	WArray* filtered = filterParallel( array, filter, filterData, true, threads );
+
+	assert( filtered );
+	assert( warray_size( filtered ) <= warray_size( array ));
+	assert( warray_all( filtered, filter, filterData ));
+	return checkArray( filtered );
+}
+
+WArray*
+warray_rejectParallel( const WArray* array, WElementCondition* reject, const void* rejectData, size_t threads )
+{
+	assert( array );
+	assert( reject );
+
+	WArray* rejected = filterParallel( array, reject, rejectData, false, threads );
+
+	assert( rejected );
+	assert( warray_size( rejected ) <= warray_size( array ));
+	assert( warray_none( rejected, reject, rejectData ));
+	return checkArray( rejected );
+}
+
+WArray*
+warray_mapParallel( const WArray* array, WElementMap* map, const void* mapData, const WType* type, size_t threads )
+{
+	assert( array );
+	assert( map );
+
+	if ( not type ) type = wtypePtr;
+	WArray* mapped = warray_new( array->capacity, type );
+
+	size_t count;
+	ChunkTask* tasks = newChunks( array, threads, ParallelChunkMinimum, &count, (ChunkTask){
+		.target = mapped, .map = map, .data = mapData });
+	runChunks( mapChunk, tasks, count, threads );
+	free( tasks );
+
+	//Moving the elements to another allocator needs not be thread safe.
+	if ( elementAllocator( mapped ) != wallocatorDefault )
+		for ( size_t i = 0; i < array->size; i++ )
+			mapped->data[i] = adoptElement( mapped, mapped->data[i] );
+	mapped->size = array->size;
+
+	assert( mapped );
+	assert( mapped->size == array->size );
+	assert( mapped->type == type );
+	return checkArray( mapped );
+}
+
+void*
+warray_reduceParallel( const WArray* array, WElementReduce* reduce, WElementCombine* combine, const void* startValue,
+	const WType* type, size_t threads )
+{
+	assert( array );
+	assert( reduce );
+	assert( combine );
+
+	if ( not type ) type = wtypePtr;
+	if ( array->size <= ReduceChunkSize )
+		return warray_reduce( array, reduce, startValue, type );
+
+	//The chunks only depend on the array size, the threads just pick them up.
+	WArray target = { .type = type };
+	size_t count = (array->size + ReduceChunkSize-1) / ReduceChunkSize;
+	ChunkTask* tasks = __wxmalloc( count * sizeof( ChunkTask ));
+	for ( size_t i = 0; i < count; i++ )
+		tasks[i] = (ChunkTask){ .array = array, .target = &target, .begin = i * ReduceChunkSize,
+			.end = __wmin( (i+1) * ReduceChunkSize, array->size ), .reduce = reduce, .data = i ? NULL : startValue };
+	runChunks( reduceChunk, tasks, count, threads );
+
+	void* reduction = tasks[0].result;
+	for ( size_t i = 1; i < count; i++ ) {
+		void* combined = combine( reduction, tasks[i].result );
+		type->delete( &reduction );
+		type->delete( &tasks[i].result );
+		reduction = combined;
+	}
+	free( tasks );
+
+	return reduction;
+}
+
+size_t
+warray_count( const WArray* array, WElementCondition* condition, const void* conditionData )
+{
+	assert( array );
+	assert( condition );
+
+	if ( not array->elementSize and (condition == wtypePtr_conditionEquals or condition == wtypeInt_conditionEquals ))
+		return scanCount( array->data, array->size, conditionData );
+
+	size_t count = 0;
+
+    for ( size_t i = 0; i < array->size; i++ ) {
+		if ( condition( elementAt( array, i ), conditionData ))
+			count++;
+    }
+
+	assert( count <= array->size );
+	return count;
+}
+
+ssize_t
+warray_index( const WArray* array, const void* element )
+{
+	assert( array );
+	assert( array->type->compare );
+
+	if ( array->index )
+		return indexLookup( array, element, false );
+	if ( array->prefixes )
+		return prefixLookup( array, element, false );
+
+	if ( hasScalarSlots( array )) {
+		size_t position = scanIndex( array->data, array->size, element );
+		return position < array->size ? (ssize_t)position : -1;
+	}
+
+	WElementCompare* compare = array->type->compare;
+
+	for ( size_t i = 0; i < array->size; i++ ) {
+		if ( compare( element, elementAt( array, i )) == 0 ) {
+			assert( i <= array->size );
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+ssize_t
+warray_rindex( const WArray* array, const void* element )
+{
+	assert( array );
+	assert( array->type->compare );
+
+	if ( array->index )
+		return indexLookup( array, element, true );
+	if ( array->prefixes )
+		return prefixLookup( array, element, true );
+
+	if ( hasScalarSlots( array )) {
+		size_t position = scanRindex( array->data, array->size, element );
+		return position < array->size ? (ssize_t)position : -1;
+	}
+
+	WElementCompare* compare = array->type->compare;
+
+	for ( size_t i = array->size-1; i < array->size; i-- ) {
+		if ( compare( element, elementAt( array, i )) == 0 ) {
+			assert( i <= array->size );
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+WArray*
+warray_enableIndex( WArray* array )
+{
+	assert( array );
+	assert( array->type->compare );
+	assert( array->type->hash );
+
+	if ( not array->index ) {
+		array->index = __wxnew( WArrayIndex, .stale = true );
+		rebuildIndex( array );
+	}
+
+	assert( array->index );
+	return checkArray( array );
+}
+
+WArray*
+warray_disableIndex( WArray* array )
+{
+	assert( array );
+
+	deleteIndex( &array->index );
+
+	assert( not array->index );
+	return checkArray( array );
+}
+
+WArray*
+warray_enablePrefixes( WArray* array )
+{
+	assert( array );
+	assert( not array->elementSize );
+	assert( array->type->compare == wtypeStr_compare );
+
+	if ( not array->prefixes )
+		array->prefixes = __wxnew( WArrayPrefixes, .count = 0 );
+
+	assert( array->prefixes );
+	return checkArray( array );
+}
+
+WArray*
+warray_disablePrefixes( WArray* array )
+{
+	assert( array );
+
+	deletePrefixes( &array->prefixes );
+
+	assert( not array->prefixes );
+	return checkArray( array );
+}
+
+//Append the text of the element at the position to the string buffer.
+static void
+appendElementText( const WArray* array, size_t position, WStrBuf* buf )
+{
+	const void* element = elementAt( array, position );
+	if ( not element )
+		wstrbuf_append( buf, "(NULL)" );
+	else if ( array->type->toStrBuf )
+		array->type->toStrBuf( element, buf );
+	else {
+		char* elementStr = array->type->toString( element );
+		assert( elementStr );
+		wstrbuf_append( buf, elementStr );
+		free( elementStr );
+	}
+}
+
+char*
+warray_toString( const WArray* array, const char delimiter[] )
+{
+	assert( array );
+	assert( delimiter );
+	assert( array->type->toString or array->type->toStrBuf );
+
+	WStrBuf* buf = wstrbuf_new( 0 );
+	size_t delimiterLength = strlen( delimiter );
+
+	for ( size_t i = 0; i < array->size; i++ ) {
+		if ( i ) wstrbuf_appendn( buf, delimiter, delimiterLength );
+		appendElementText( array, i, buf );
+	}
+
+	char* string = wstrbuf_steal( &buf );
+	assert( string );
+	return string;
+}
+
+WArray*
+warray_fromString( const char string[], const char delimiter[], const WType* targetType )
+{
+	assert( string );
+	assert( delimiter and delimiter[0] );
+	assert( targetType );
+	assert( targetType->clone and targetType->delete and targetType->fromString );
+
+	WArray* array = warray_new( 0, targetType );
+
+	char* newString = __wstr_dup( string );
+	char* context = NULL;
+	char* token = __wstr_sep_r( newString, delimiter, &context );
+
+	while ( token ) {
+		if ( strcmp( token, "(NULL)" ) != 0 ) {
+			void* element = targetType->fromString( token );
+			assert( element );
+			warray_pushLast( array, element );		//Take the new element over instead of cloning it.
+		}
+		else
+			warray_append( array, NULL );
+		token = __wstr_sep_r( NULL, delimiter, &context );
+	}
+
+	free( newString );
+
+	assert( array );
+	return checkArray( array );
+}
+
+WArray*
+warray_splitView( const char string[], const char delimiter[] )
+{
+	assert( string );
+	assert( delimiter and delimiter[0] );
+
+	WArray* array = warray_new( 0, wtypeStrArena );
+
+	//One copy of the text, owned by the array arena like all its elements.
+	size_t size = strlen( string ) + 1;
+	char* token = memcpy( warena_alloc( array->arena, size ), string, size );
+	size_t delimiterLength = strlen( delimiter );
+
+	while ( *token ) {		//Like __wstr_sep_r(), only a trailing empty token is dropped.
+		char* end = delimiterLength == 1 ? strchr( token, delimiter[0] ) : strstr( token, delimiter );
+		if ( end ) *end = '\0';
+
+		resize( array, array->size+1 );
+		array->data[array->size++] = strcmp( token, "(NULL)" ) != 0 ? token : NULL;
+
+		if ( not end ) break;
+		token = end + delimiterLength;
+	}
+
+	assert( array );
+	assert( array->type == wtypeStrArena );
+	return checkArray( array );
+}
+
+int
+warray_compare( const WArray* array1, const WArray* array2 )
+{
+	assert( array1 );
+	assert( array2 );
+	assert( array1->type == array2->type && "Can't compare arrays of different type." );
+	assert( array1->type->compare != NULL && "Need a comparison function." );
+
+	//Setup some variables to save avoid unnecessary pointer accesses in the loop.
+	WElementCompare* compare = array1->type->compare;
+	assert( array1->elementSize == array2->elementSize );
+
+	//Skip the equal elements at once if they are stored by value.
+	size_t start = 0;
+	if ( hasScalarSlots( array1 ))
+		start = scanMismatch( array1->data, array2->data, __wmin( array1->size, array2->size ));
+
+	//Compare all elements with each other until one array ends or a difference is found.
+	for ( size_t i = start; i < array1->size and i < array2->size; i++ ) {
+		int result = compare( elementAt( array1, i ), elementAt( array2, i ));
+		if ( result ) return result;
+	}
+
+	//The compared elements were equal, now compare the sizes.
+	return (ssize_t)array1->size - (ssize_t)array2->size;
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+const void*
+warray_min( const WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+	assert( array->type->compare && "Need a comparison method!" );
+
+	if ( hasScalarSlots( array ))
+		return (void*)scanMin( array->data, array->size );
+
+	WElementCompare* compare = array->type->compare;
+
+    void* minimum = elementAt( array, 0 );
+    for ( size_t i = 1; i < array->size; i++ ) {
+		void* element = elementAt( array, i );
+		if ( compare( element, minimum ) < 0 )
+			minimum = element;
+    }
+
+	return minimum;
+}
+
+const void*
+warray_max( const WArray* array )
+{
+	assert( array );
+	assert( warray_nonEmpty( array ));
+	assert( array->type->compare && "Need a comparison method!" );
+
+	if ( hasScalarSlots( array ))
+		return (void*)scanMax( array->data, array->size );
+
+	WElementCompare* compare = array->type->compare;
+
+    void* maximum = elementAt( array, 0 );
+    for ( size_t i = 1; i < array->size; i++ ) {
+		void* element = elementAt( array, i );
+		if ( compare( element, maximum ) > 0 )
+			maximum = element;
+    }
+
+	return maximum;
+}
+
+ssize_t
+warray_search( const WArray* array, WElementCompare* compare, const void* key )
+{
+	assert( array );
+	assert( compare && "Need a comparison function!" );
+
+	for ( size_t i = 0; i < array->size; i++ ) {
+		if ( compare( key, elementAt( array, i )) == 0 )
+			return i;
+	}
+
+	return -1;
+}
+
+// Helper struct to get both the bsearch comparison function and the key into our actual comparison function.
+typedef struct ElementComparer {
+	WElementCompare* compare;
+	const void*		element;
+}ElementComparer;
+
+static inline int
+compareKeyWithElement( const void* key, const void* element )
+{
+	//Extract the comparison function and the key.
+	const ElementComparer* keyComparer = key;
+	//bsearch gives us a pointer to the element, we deliver the element itself to the client comparison function.
+	return keyComparer->compare( keyComparer->element, *(void**)element );
+}
+
+//Dto. for inline arrays, where bsearch gives us the element itself.
+static inline int
+compareKeyWithInlineElement( const void* key, const void* element )
+{
+	const ElementComparer* keyComparer = key;
+	return keyComparer->compare( keyComparer->element, element );
+}
+
+ssize_t
+warray_bsearch( const WArray* array, WElementCompare* compare, const void* key )
+{
+	assert( array );
+	assert( compare && "Need a comparison function!" );
+
+	if ( not array->size ) return -1;
+	if ( array->prefixes and compare == wtypeStr_compare )
+		return prefixSearch( array, key );
+
+	ElementComparer keyComparer = { .compare = compare, .element = key };
+	char* element = bsearch( &keyComparer, array->data, array->size, slotSize( array ),
+		array->elementSize ? compareKeyWithInlineElement : compareKeyWithElement );
+	if ( not element ) return -1;
+
+	assert( element >= slotAt( array, 0 ));
+	assert( element < slotAt( array, array->size ));
+
+	size_t position = (element - slotAt( array, 0 )) / slotSize( array );
+	assert( position <= array->size );
+	assert( compare( key, warray_at( array, position )) == 0 );
+	return position;
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+WArray*
+warray_reverse( WArray* array )
+{
+	assert( array );
+
+	ssize_t front = 0;
+	ssize_t back = array->size-1;
+
+	while ( front < back ) {
+		swapSlots( array, front, back );
+		front++;
+		back--;
+	}
+	invalidateIndex( array );
+
+	assert( array );
+	return checkArray( array );
+}
+
+WArray*
+warray_shuffle( WArray* array )
+{
+	assert( array );
+
+	for ( size_t i = 0; i < array->size; i++ ) {
+        size_t position = rand() % array->size;
+        swapSlots( array, i, position );
+	}
+	invalidateIndex( array );
+
+	assert( array );
+	return checkArray( array );
+}
+
+WArray*
+warray_compact( WArray* array )
+{
+	assert( array );
+
+	if ( array->elementSize ) return checkArray( array );	//Inline elements are never NULL.
+
+	size_t write = 0;
+    for ( size_t read = 0; read < array->size; read++ ) {
+		void* value = array->data[read];
+		if ( value ) array->data[write++] = value;
+    }
+
+    array->size = write;
+	invalidateIndex( array );
+
+	assert( array );
+	assert( not warray_contains( array, NULL ));
+	return checkArray( array );
+}
+
+//-------------------------------------------------------------------------------
+//	Pattern-defeating quicksort
+//-------------------------------------------------------------------------------
+
+/*	DEFINE_SORT( name, LESS ) defines a pattern-defeating quicksort
+	static void name( void** data, size_t n, WElementCompare* compare )
+	with the LESS( element1, element2 ) expression inlined into every comparison. Ranges with
+	many equal elements are partitioned in linear time, already sorted runs are detected with a
+	bounded insertion sort and bad pivots are defeated by shuffling, at last by heap sort.
+*/
+#define DEFINE_SORT( name, LESS )																	\
+static inline bool																					\
+name##_less( void* element1, void* element2, WElementCompare* compare )								\
+{																									\
+	return LESS( element1, element2 );																\
+}																									\
+																									\
+static void																							\
+name##_insertion( void** begin, void** end, WElementCompare* compare )								\
+{																									\
+	for ( void** current = begin+1; current < end; current++ ) {									\
+		void* element = *current;																	\
+		void** sift = current;																		\
+		for ( ; sift > begin and name##_less( element, sift[-1], compare ); sift-- )				\
+			*sift = sift[-1];																		\
+		*sift = element;																			\
+	}																								\
+}																									\
+																									\
+/*Insertion sort, but give up if too many elements have to be moved.*/								\
+static bool																							\
+name##_partialInsertion( void** begin, void** end, WElementCompare* compare )						\
+{																									\
+	size_t moves = 0;																				\
+	for ( void** current = begin+1; current < end; current++ ) {									\
+		if ( not name##_less( *current, current[-1], compare )) continue;							\
+		void* element = *current;																	\
+		void** sift = current;																		\
+		for ( ; sift > begin and name##_less( element, sift[-1], compare ); sift-- )				\
+			*sift = sift[-1];																		\
+		*sift = element;																			\
+		moves += current - sift;																	\
+		if ( moves > SortPartialLimit ) return false;												\
+	}																								\
+	return true;																					\
+}																									\
+																									\
+static inline void																					\
+name##_sort2( void** a, void** b, WElementCompare* compare )										\
+{																									\
+	if ( name##_less( *b, *a, compare )) { void* swap = *a; *a = *b; *b = swap; }					\
+}																									\
+																									\
+static inline void																					\
+name##_sort3( void** a, void** b, void** c, WElementCompare* compare )								\
+{																									\
+	name##_sort2( a, b, compare );																	\
+	name##_sort2( b, c, compare );																	\
+	name##_sort2( a, b, compare );																	\
+}																									\
+																									\
+static void																							\
+name##_siftDown( void** data, size_t root, size_t n, WElementCompare* compare )						\
+{																									\
+	void* element = data[root];																		\
+	for ( size_t child; (child = 2*root+1) < n; root = child ) {									\
+		if ( child+1 < n and name##_less( data[child], data[child+1], compare )) child++;			\
+		if ( not name##_less( element, data[child], compare )) break;								\
+		data[root] = data[child];																	\
+	}																								\
+	data[root] = element;																			\
+}																									\
+																									\
+static void																							\
+name##_heapSort( void** begin, void** end, WElementCompare* compare )								\
+{																									\
+	size_t n = end - begin;																			\
+	for ( size_t i = n/2; i-- > 0; )																\
+		name##_siftDown( begin, i, n, compare );													\
+	for ( size_t i = n; i-- > 1; ) {																\
+		swapPointers( begin, begin+i );																\
+		name##_siftDown( begin, 0, i, compare );													\
+	}																								\
+}																									\
+																									\
+/*Put elements less than the pivot *begin left of it. The pivot's position is returned, */			\
+/*partitioned tells whether no element had to be moved.*/											\
+static void**																						\
+name##_partitionRight( void** begin, void** end, bool* partitioned, WElementCompare* compare )		\
+{																									\
+	void* pivot = *begin;																			\
+	void** first = begin;																			\
+	void** last = end;																				\
+	while ( name##_less( *++first, pivot, compare ));	/*The median selection guarantees a stop.*/	\
+	if ( first-1 == begin )																			\
+		while ( first < last and not name##_less( *--last, pivot, compare ));						\
+	else																							\
+		while ( not name##_less( *--last, pivot, compare ));										\
+																									\
+	*partitioned = first >= last;																	\
+	while ( first < last ) {																		\
+		swapPointers( first, last );																\
+		while ( name##_less( *++first, pivot, compare ));											\
+		while ( not name##_less( *--last, pivot, compare ));										\
+	}																								\
+																									\
+	*begin = first[-1];																				\
+	first[-1] = pivot;																				\
+	return first-1;																					\
+}																									\
+																									\
+/*Put elements equal to the pivot *begin left of it, used if the pivot equals its left */			\
+/*neighbour, a former pivot. The elements left of the returned position are all equal.*/			\
+static void**																						\
+name##_partitionLeft( void** begin, void** end, WElementCompare* compare )							\
+{																									\
+	void* pivot = *begin;																			\
+	void** first = begin;																			\
+	void** last = end;																				\
+	while ( name##_less( pivot, *--last, compare ));												\
+	if ( last+1 == end )																			\
+		while ( first < last and not name##_less( pivot, *++first, compare ));						\
+	else																							\
+		while ( not name##_less( pivot, *++first, compare ));										\
+																									\
+	while ( first < last ) {																		\
+		swapPointers( first, last );																\
+		while ( name##_less( pivot, *--last, compare ));											\
+		while ( not name##_less( pivot, *++first, compare ));										\
+	}																								\
+																									\
+	*begin = *last;																					\
+	*last = pivot;																					\
+	return last;																					\
+}																									\
+																									\
+static void																							\
+name##_loop( void** begin, void** end, int badAllowed, bool leftmost, WElementCompare* compare )	\
+{																									\
+	while ( true ) {																				\
+		size_t size = end - begin;																	\
+		if ( size < SortInsertionLimit ) {															\
+			name##_insertion( begin, end, compare );												\
+			return;																					\
+		}																							\
+																									\
+		size_t half = size / 2;																		\
+		if ( size > SortNintherLimit ) {															\
+			name##_sort3( begin, begin+half, end-1, compare );										\
+			name##_sort3( begin+1, begin+half-1, end-2, compare );									\
+			name##_sort3( begin+2, begin+half+1, end-3, compare );									\
+			name##_sort3( begin+half-1, begin+half, begin+half+1, compare );						\
+			swapPointers( begin, begin+half );														\
+		}																							\
+		else																						\
+			name##_sort3( begin+half, begin, end-1, compare );										\
+																									\
+		if ( not leftmost and not name##_less( begin[-1], *begin, compare )) {	/*Skip a run of equal elements.*/	\
+			begin = name##_partitionLeft( begin, end, compare ) + 1;								\
+			continue;																				\
+		}																							\
+																									\
+		bool partitioned;																			\
+		void** pivot = name##_partitionRight( begin, end, &partitioned, compare );					\
+		size_t left = pivot - begin;																\
+		size_t right = end - (pivot+1);																\
+		if ( left < size/8 or right < size/8 ) {	/*Bad pivot, break up possible patterns.*/		\
+			if ( --badAllowed == 0 ) {																\
+				name##_heapSort( begin, end, compare );												\
+				return;																				\
+			}																						\
+			if ( left >= SortInsertionLimit ) {														\
+				swapPointers( begin, begin+left/4 );												\
+				swapPointers( pivot-1, pivot-left/4 );												\
+			}																						\
+			if ( right >= SortInsertionLimit ) {													\
+				swapPointers( pivot+1, pivot+1+right/4 );											\
+				swapPointers( end-1, end-right/4 );													\
+			}																						\
+		}																							\
+		else if ( partitioned and name##_partialInsertion( begin, pivot, compare )					\
+				and name##_partialInsertion( pivot+1, end, compare ))								\
+			return;																					\
+																									\
+		name##_loop( begin, pivot, badAllowed, leftmost, compare );									\
+		begin = pivot+1;																			\
+		leftmost = false;																			\
+	}																								\
+}																									\
+																									\
+static void																							\
+name( void** data, size_t n, WElementCompare* compare )												\
+{																									\
+	int badAllowed = 1;																				\
+	while ( n >> badAllowed ) badAllowed++;	/*log2(n)+1*/											\
+	if ( n > 1 ) name##_loop( data, data+n, badAllowed, true, compare );							\
+}
+
+static inline void
+swapPointers( void** a, void** b )
+{
+	void* swap = *a;
+	*a = *b;
+	*b = swap;
+}
+
+//Any element type, calling the compare function directly.
+#define LESS_COMPARE( e1, e2 )	(compare( e1, e2 ) < 0)
+DEFINE_SORT( sortGeneric, LESS_COMPARE )
+
+//Specialisations of the builtin types. NULL elements are less than any other element.
+#define LESS_INT( e1, e2 )		((void)compare, (long)(e1) < (long)(e2))
+DEFINE_SORT( sortInt, LESS_INT )
+
+#define LESS_DOUBLE( e1, e2 )	((void)compare, (e2) and (not (e1) or *(double*)(e1) < *(double*)(e2)))
+DEFINE_SORT( sortDouble, LESS_DOUBLE )
+
+#define LESS_STR( e1, e2 )		((void)compare, (e2) and (not (e1) or strcmp( e1, e2 ) < 0))
+DEFINE_SORT( sortStr, LESS_STR )
+
+//-------------------------------------------------------------------------------
+//	Radix sorts
+//-------------------------------------------------------------------------------
+
+enum {
+	RadixLimit = 512,			//Smaller arrays are sorted by comparison.
+	RadixStringLimit = 64,		//Smaller string buckets are sorted by comparison.
+	RadixStringDepth = 128		//Deeper string buckets are sorted by comparison.
+};
+
+//An element with its key, keys are ordered like the elements as unsigned numbers.
+typedef struct RadixItem {
+	uint64_t key;
+	void* element;
+} RadixItem;
+
+/*	LSD radix sort of the items by key, one counting pass for all eight bytes and one
+	distribution pass per byte, skipping bytes which are equal in all keys. The result is
+	either in items or in buffer, the returned one.
+*/
+static RadixItem*
+radixSortItems( RadixItem* items, RadixItem* buffer, size_t n )
+{
+	size_t counts[8][256] = {{ 0 }};
+	for ( size_t i = 0; i < n; i++ )
+		for ( int byte = 0; byte < 8; byte++ )
+			counts[byte][(items[i].key >> 8*byte) & 0xff]++;
+
+	for ( int byte = 0; byte < 8; byte++ ) {
+		size_t* count = counts[byte];
+		if ( count[(items[0].key >> 8*byte) & 0xff] == n ) continue;	//All keys share the byte.
+
+		size_t start = 0;
+		for ( int digit = 0; digit < 256; digit++ ) {
+			size_t next = start + count[digit];
+			count[digit] = start;
+			start = next;
+		}
+		for ( size_t i = 0; i < n; i++ )
+			buffer[count[(items[i].key >> 8*byte) & 0xff]++] = items[i];
+
+		RadixItem* swap = items;
+		items = buffer;
+		buffer = swap;
+	}
+	return items;
+}
+
+//Sort the elements by the keys of the items and write them back in sorted order.
+static void
+radixSortKeys( void** data, RadixItem* items, size_t n )
+{
+	RadixItem* buffer = __wxmalloc( n * sizeof( RadixItem ));
+	RadixItem* sorted = radixSortItems( items, buffer, n );
+	for ( size_t i = 0; i < n; i++ )
+		data[i] = sorted[i].element;
+	free( buffer );
+}
+
+static void
+radixSortInt( void** data, size_t n )
+{
+	RadixItem* items = __wxmalloc( n * sizeof( RadixItem ));
+	for ( size_t i = 0; i < n; i++ )	//Flipping the sign bit orders negative numbers first.
+		items[i] = (RadixItem){ (uint64_t)(long)data[i] ^ (UINT64_C(1) << 63), data[i] };
+	radixSortKeys( data, items, n );
+	free( items );
+}
+
+//Map a double to an unsigned number with the same order. NaN values go to the ends.
+static inline uint64_t
+doubleKey( double value )
+{
+	uint64_t bits;
+	memcpy( &bits, &value, sizeof( bits ));
+	return bits & (UINT64_C(1) << 63) ? ~bits : bits | (UINT64_C(1) << 63);
+}
+
+static void
+radixSortDouble( void** data, size_t n )
+{
+	size_t nulls = 0;	//NULL elements are less than any double, move them to the front.
+	for ( size_t i = 0; i < n; i++ )
+		if ( not data[i] ) swapPointers( &data[nulls++], &data[i] );
+
+	data += nulls;
+	n -= nulls;
+	if ( not n ) return;
+
+	RadixItem* items = __wxmalloc( n * sizeof( RadixItem ));
+	for ( size_t i = 0; i < n; i++ )
+		items[i] = (RadixItem){ doubleKey( *(double*)data[i] ), data[i] };
+	radixSortKeys( data, items, n );
+	free( items );
+}
+
+/*	MSD radix sort of strings from the byte at depth on, the strings are equal before. Strings
+	ending at depth are equal and done, the others are distributed by their byte and sorted
+	recursively. Small or deep buckets are sorted by comparison instead.
+*/
+static void
+radixSortStrBuckets( char** data, char** buffer, size_t n, size_t depth )
+{
+	if ( n < RadixStringLimit or depth > RadixStringDepth ) {
+		sortStr( (void**)data, n, wtypeStr_compare );
+		return;
+	}
+
+	size_t counts[256] = { 0 };
+	for ( size_t i = 0; i < n; i++ )
+		counts[(unsigned char)data[i][depth]]++;
+
+	size_t starts[256];
+	size_t start = 0;
+	for ( int digit = 0; digit < 256; digit++ ) {
+		starts[digit] = start;
+		start += counts[digit];
+	}
+	for ( size_t i = 0; i < n; i++ )
+		buffer[starts[(unsigned char)data[i][depth]]++] = data[i];
+	memcpy( data, buffer, n * sizeof( char* ));
+
+	char** bucket = data + counts[0];
+	for ( int digit = 1; digit < 256; digit++ ) {
+		if ( counts[digit] > 1 )
+			radixSortStrBuckets( bucket, buffer, counts[digit], depth+1 );
+		bucket += counts[digit];
+	}
+}
+
+/*	Sort the strings by their abbreviated keys first, which reads every string once and then
+	works on a contiguous array. Only strings with equal keys of eight non-zero bytes need to be
+	sorted further from the ninth byte on.
+*/
+static void
+radixSortStr( void** data, size_t n )
+{
+	size_t nulls = 0;	//NULL elements are less than any string, move them to the front.
+	for ( size_t i = 0; i < n; i++ )
+		if ( not data[i] ) swapPointers( &data[nulls++], &data[i] );
+
+	data += nulls;
+	n -= nulls;
+	if ( not n ) return;
+
+	RadixItem* items = __wxmalloc( n * sizeof( RadixItem ));
+	for ( size_t i = 0; i < n; i++ )
+		items[i] = (RadixItem){ stringPrefix( data[i] ), data[i] };
+	RadixItem* buffer = __wxmalloc( n * sizeof( RadixItem ));
+	RadixItem* sorted = radixSortItems( items, buffer, n );
+	for ( size_t i = 0; i < n; i++ )
+		data[i] = sorted[i].element;
+
+	char** strings = (char**)(sorted == items ? buffer : items);	//The other one is free.
+	for ( size_t begin = 0, end; begin < n; begin = end ) {
+		for ( end = begin+1; end < n and sorted[end].key == sorted[begin].key; end++ );
+		if ( end-begin > 1 and (sorted[begin].key & 0xff) )
+			radixSortStrBuckets( (char**)data + begin, strings, end-begin, 8 );
+	}
+	free( buffer );
+	free( items );
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+//Pick the specialisation matching the compare function, large arrays of builtin types are
+//radix sorted.
+static void
+sortPointers( void** data, size_t n, WElementCompare* compare )
+{
+	bool radix = n >= RadixLimit;
+	if ( compare == wtypeInt_compare )
+		radix ? radixSortInt( data, n ) : sortInt( data, n, compare );
+	else if ( compare == wtypeDouble_compare )
+		radix ? radixSortDouble( data, n ) : sortDouble( data, n, compare );
+	else if ( compare == wtypeStr_compare )
+		radix ? radixSortStr( data, n ) : sortStr( data, n, compare );
+	else
+		sortGeneric( data, n, compare );
+}
+
+//-------------------------------------------------------------------------------
+//	Parallel sort
+//-------------------------------------------------------------------------------
+
+enum {
+	ParallelSortLimit = 1 << 20,	//warray_sortBy() sorts larger arrays in parallel.
+	ParallelSortMinimum = 1 << 14	//Elements per task worth the scheduling.
+};
+
+/*	A piece of work for one pool task: sort data[begin, end) or merge the sorted runs
+	source[begin, middle) and source[middle, end) into target[begin, end). Merges may be split
+	into slices, which take the runs from aBegin, bBegin on and write to target from begin on.
+*/
+typedef struct SortTask {
+	void** source;
+	void** target;
+	size_t begin, end;
+	size_t aBegin, aEnd, bBegin, bEnd;
+	WElementCompare* compare;
+} SortTask;
+
+static void
+sortTask( void* argument )
+{
+	SortTask* task = argument;
+	sortPointers( task->source + task->begin, task->end - task->begin, task->compare );
+}
+
+//Merge the slice of the two runs, taking the first run's element on equality.
+static void
+mergeTask( void* argument )
+{
+	SortTask* task = argument;
+	void** source = task->source;
+	void** target = task->target + task->begin;
+	size_t a = task->aBegin, b = task->bBegin;
+	while ( a < task->aEnd and b < task->bEnd )
+		*target++ = task->compare( source[b], source[a] ) < 0 ? source[b++] : source[a++];
+	memcpy( target, source+a, (task->aEnd-a) * sizeof( void* ));
+	target += task->aEnd-a;
+	memcpy( target, source+b, (task->bEnd-b) * sizeof( void* ));
+}
+
+//Run the tasks in the default pool and wait for them.
+static void
+runTasks( WTask* function, SortTask* tasks, size_t count )
+{
+	wpool_run( wpool_default(), function, tasks, count, sizeof( SortTask ));
+}
+
+//First position in the sorted data[begin, end) with an element not less than element.
+static size_t
+lowerBound( void** data, size_t begin, size_t end, void* element, WElementCompare* compare )
+{
+	while ( begin < end ) {
+		size_t middle = begin + (end-begin) / 2;
+		if ( compare( data[middle], element ) < 0 )
+			begin = middle+1;
+		else
+			end = middle;
+	}
+	return begin;
+}
+
+//One task per thread of the default pool.
+static size_t
+defaultThreads( void )
+{
+	return wpool_threads( wpool_default() );
+}
+
+/*	Sort runs of the data in parallel, then merge pairs of neighbouring runs until one run is
+	left. Every merge is cut into slices at evenly spaced elements of the first run, so all
+	threads keep busy during the last merges as well.
+*/
+static void
+sortParallel( void** data, size_t n, WElementCompare* compare, size_t threads )
+{
+	threads = __wmin( threads, n / ParallelSortMinimum );
+	if ( threads < 2 ) {
+		sortPointers( data, n, compare );
+		return;
+	}
+
+	SortTask* tasks = __wxmalloc( threads * sizeof( SortTask ));
+	size_t* runs = __wxmalloc( (threads+1) * sizeof( size_t ));	//Run boundaries
+	for ( size_t i = 0; i <= threads; i++ )
+		runs[i] = n / threads * i + __wmin( i, n % threads );
+	for ( size_t i = 0; i < threads; i++ )
+		tasks[i] = (SortTask){ .source = data, .begin = runs[i], .end = runs[i+1], .compare = compare };
+	runTasks( sortTask, tasks, threads );
+
+	void** source = data;
+	void** target = __wxmalloc( n * sizeof( void* ));
+	void** buffer = target;
+	for ( size_t count = threads; count > 1; count = (count+1) / 2 ) {
+		size_t slices = __wmax( threads / (count/2), 1 );	//Per merge
+		size_t tasksUsed = 0;
+		for ( size_t run = 0; run < count; run += 2 ) {
+			size_t begin = runs[run], middle = runs[__wmin( run+1, count )], end = runs[__wmin( run+2, count )];
+			size_t pieces = middle < end ? slices : 1;	//A single run is just copied.
+			for ( size_t piece = 0; piece < pieces; piece++ ) {
+				size_t aBegin = begin + (middle-begin) * piece / pieces;
+				size_t aEnd = begin + (middle-begin) * (piece+1) / pieces;
+				size_t bBegin = piece ? lowerBound( source, middle, end, source[aBegin], compare ) : middle;
+				size_t bEnd = piece+1 < pieces ? lowerBound( source, middle, end, source[aEnd], compare ) : end;
+				if ( tasksUsed == threads ) {
+					runTasks( mergeTask, tasks, tasksUsed );
+					tasksUsed = 0;
+				}
+				tasks[tasksUsed++] = (SortTask){ source, target, aBegin + bBegin-middle, end, aBegin, aEnd, bBegin, bEnd, compare };
+			}
+			runs[run/2] = begin;
+		}
+		runs[(count+1)/2] = n;
+		runTasks( mergeTask, tasks, tasksUsed );
+
+		void** swap = source;
+		source = target;
+		target = swap;
+	}
+
+	if ( source != data )
+		memcpy( data, source, n * sizeof( void* ));
+	free( buffer );
+	free( runs );
+	free( tasks );
+}
+
+//-------------------------------------------------------------------------------
+//	Stable adaptive sort
+//-------------------------------------------------------------------------------
+
+enum {
+	StableMinGallop = 7,	//Wins in a row before a merge starts galloping.
+	StableMaxRuns = 85		//The run length invariants keep fewer runs pending for any size_t n.
+};
+
+/*	The state of a timsort-like merge sort. Natural runs are found, short ones extended by
+	binary insertion sort and pushed on a stack of pending runs, which is merged so that the
+	run lengths grow at least like the Fibonacci numbers.
+*/
+typedef struct StableSort {
+	void** data;
+	void** buffer;				//Allocated at the first merge, so sorted input needs none.
+	size_t n;
+	WElementCompare* compare;
+	size_t minGallop;			//Adapts to the data, galloping pays off or not.
+	size_t runs;
+	size_t runBegin[StableMaxRuns];
+	size_t runLength[StableMaxRuns];
+} StableSort;
+
+//Runs shorter than this are extended, so the number of runs is a power of two or a bit less.
+static size_t
+minRunLength( size_t n )
+{
+	size_t odd = 0;
+	for ( ; n >= 64; n >>= 1 )
+		odd |= n & 1;
+	return n + odd;
+}
+
+//Length of the natural run at data[begin], a strictly descending run is reversed in place.
+static size_t
+countRun( void** data, size_t begin, size_t end, WElementCompare* compare )
+{
+	size_t run = begin+1;
+	if ( run == end ) return 1;
+
+	if ( compare( data[run++], data[begin] ) < 0 ) {
+		while ( run < end and compare( data[run], data[run-1] ) < 0 ) run++;
+		for ( size_t low = begin, high = run-1; low < high; low++, high-- )
+			swapPointers( &data[low], &data[high] );
+	}
+	else
+		while ( run < end and compare( data[run], data[run-1] ) >= 0 ) run++;
+	return run - begin;
+}
+
+//Insert data[sorted, end) into the sorted data[begin, sorted), equal elements keep their order.
+static void
+binaryInsertion( void** data, size_t begin, size_t sorted, size_t end, WElementCompare* compare )
+{
+	for ( ; sorted < end; sorted++ ) {
+		void* element = data[sorted];
+		size_t low = begin, high = sorted;
+		while ( low < high ) {
+			size_t middle = low + (high-low) / 2;
+			if ( compare( element, data[middle] ) < 0 )
+				high = middle;
+			else
+				low = middle+1;
+		}
+		memmove( &data[low+1], &data[low], (sorted-low) * sizeof( void* ));
+		data[low] = element;
+	}
+}
+
+/*	The number of elements in the sorted run going before the key: the elements less than key,
+	or with after also the equal ones. The search probes exponentially growing steps from the
+	start or the end of the run and then finishes with a binary search.
+*/
+static size_t
+gallop( void* key, void** run, size_t n, bool fromEnd, bool after, WElementCompare* compare )
+{
+	#define GOES_BEFORE( position )	(after ? compare( key, run[position] ) >= 0 : compare( run[position], key ) < 0)
+	size_t low = 0, high = n;
+	for ( size_t step = 0; step < n; step = 2*step+1 ) {
+		size_t position = fromEnd ? n-1-step : step;
+		if ( GOES_BEFORE( position )) {
+			low = position+1;
+			if ( fromEnd ) break;
+		}
+		else {
+			high = position;
+			if ( not fromEnd ) break;
+		}
+	}
+	while ( low < high ) {
+		size_t middle = low + (high-low) / 2;
+		if ( GOES_BEFORE( middle ))
+			low = middle+1;
+		else
+			high = middle;
+	}
+	return low;
+	#undef GOES_BEFORE
+}
+
+//Merge the neighbouring runs a and b from the front, a is the shorter one and moves to the buffer.
+static void
+mergeLow( StableSort* sort, void** a, size_t na, void** b, size_t nb )
+{
+	WElementCompare* compare = sort->compare;
+	void** pa = memcpy( sort->buffer, a, na * sizeof( void* ));
+	void** target = a;
+
+	while ( na and nb ) {
+		size_t aWins = 0, bWins = 0;	//One element at a time until a run wins repeatedly.
+		while ( na and nb and aWins < sort->minGallop and bWins < sort->minGallop ) {
+			if ( compare( *b, *pa ) < 0 ) {
+				*target++ = *b++;
+				nb--;
+				bWins++;
+				aWins = 0;
+			}
+			else {
+				*target++ = *pa++;
+				na--;
+				aWins++;
+				bWins = 0;
+			}
+		}
+		while ( na and nb ) {			//Then copy blocks, as long as they are long.
+			size_t ka = gallop( *b, pa, na, false, true, compare );
+			memcpy( target, pa, ka * sizeof( void* ));
+			target += ka;
+			pa += ka;
+			na -= ka;
+			if ( not na ) break;
+
+			size_t kb = gallop( *pa, b, nb, false, false, compare );
+			memmove( target, b, kb * sizeof( void* ));
+			target += kb;
+			b += kb;
+			nb -= kb;
+			if ( ka < StableMinGallop and kb < StableMinGallop ) {
+				sort->minGallop++;
+				break;
+			}
+			if ( sort->minGallop > 1 ) sort->minGallop--;
+		}
+	}
+	memcpy( target, pa, na * sizeof( void* ));	//Remaining b elements are in place already.
+}
+
+//Merge the neighbouring runs a and b from the back, b is the shorter one and moves to the buffer.
+static void
+mergeHigh( StableSort* sort, void** a, size_t na, void** b, size_t nb )
+{
+	WElementCompare* compare = sort->compare;
+	void** pb = memcpy( sort->buffer, b, nb * sizeof( void* ));
+	void** target = b + nb;
+
+	while ( na and nb ) {
+		size_t aWins = 0, bWins = 0;
+		while ( na and nb and aWins < sort->minGallop and bWins < sort->minGallop ) {
+			if ( compare( pb[nb-1], a[na-1] ) < 0 ) {
+				*--target = a[--na];
+				aWins++;
+				bWins = 0;
+			}
+			else {
+				*--target = pb[--nb];
+				bWins++;
+				aWins = 0;
+			}
+		}
+		while ( na and nb ) {
+			size_t ka = na - gallop( pb[nb-1], a, na, true, true, compare );
+			target -= ka;
+			na -= ka;
+			memmove( target, a+na, ka * sizeof( void* ));
+			if ( not na ) break;
+
+			size_t kb = nb - gallop( a[na-1], pb, nb, true, false, compare );
+			target -= kb;
+			nb -= kb;
+			memcpy( target, pb+nb, kb * sizeof( void* ));
+			if ( ka < StableMinGallop and kb < StableMinGallop ) {
+				sort->minGallop++;
+				break;
+			}
+			if ( sort->minGallop > 1 ) sort->minGallop--;
+		}
+	}
+	memcpy( target-nb, pb, nb * sizeof( void* ));	//Remaining a elements are in place already.
+}
+
+//Merge the pending runs i and i+1.
+static void
+mergeRuns( StableSort* sort, size_t i )
+{
+	void** a = sort->data + sort->runBegin[i];
+	void** b = sort->data + sort->runBegin[i+1];
+	size_t na = sort->runLength[i];
+	size_t nb = sort->runLength[i+1];
+
+	sort->runLength[i] += nb;
+	if ( i+3 == sort->runs ) {
+		sort->runBegin[i+1] = sort->runBegin[i+2];
+		sort->runLength[i+1] = sort->runLength[i+2];
+	}
+	sort->runs--;
+
+	//Elements of a before b[0] and elements of b behind a[na-1] are in place already.
+	size_t skip = gallop( b[0], a, na, false, true, sort->compare );
+	a += skip;
+	na -= skip;
+	if ( not na ) return;
+	nb = gallop( a[na-1], b, nb, true, false, sort->compare );
+	if ( not nb ) return;
+
+	if ( not sort->buffer )
+		sort->buffer = __wxmalloc( (sort->n/2 + 1) * sizeof( void* ));
+	if ( na <= nb )
+		mergeLow( sort, a, na, b, nb );
+	else
+		mergeHigh( sort, a, na, b, nb );
+}
+
+//Merge pending runs until their lengths decrease faster than the Fibonacci numbers.
+static void
+collapseRuns( StableSort* sort )
+{
+	size_t* length = sort->runLength;
+	while ( sort->runs > 1 ) {
+		size_t i = sort->runs-2;
+		if ( (i > 0 and length[i-1] <= length[i] + length[i+1])
+		  or (i > 1 and length[i-2] <= length[i-1] + length[i] )) {
+			if ( length[i-1] < length[i+1] ) i--;
+		}
+		else if ( length[i] > length[i+1] )
+			break;
+		mergeRuns( sort, i );
+	}
+}
+
+static void
+sortStable( void** data, size_t n, WElementCompare* compare )
+{
+	StableSort sort = { .data = data, .n = n, .compare = compare, .minGallop = StableMinGallop };
+	size_t minRun = minRunLength( n );
+
+	for ( size_t begin = 0; begin < n; ) {
+		size_t run = countRun( data, begin, n, compare );
+		if ( run < minRun ) {
+			size_t extended = __wmin( minRun, n-begin );
+			binaryInsertion( data, begin, begin+run, begin+extended, compare );
+			run = extended;
+		}
+		sort.runBegin[sort.runs] = begin;
+		sort.runLength[sort.runs++] = run;
+		collapseRuns( &sort );
+		begin += run;
+	}
+
+	while ( sort.runs > 1 ) {
+		size_t i = sort.runs-2;
+		if ( i > 0 and sort.runLength[i-1] < sort.runLength[i+1] ) i--;
+		mergeRuns( &sort, i );
+	}
+	free( sort.buffer );
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------
+//	Sorting by cached keys
+//-------------------------------------------------------------------------------
+
+//The keys of all elements, computed once: element i has its keys at values[i*count].
+typedef struct KeyedSort {
+	const WSortKey* keys;
+	size_t count;
+	void** values;
+} KeyedSort;
+
+static int
+compareKeyed( const void* context, size_t position1, size_t position2 )
+{
+	const KeyedSort* sort = context;
+	void** values1 = sort->values + position1 * sort->count;
+	void** values2 = sort->values + position2 * sort->count;
+	for ( size_t k = 0; k < sort->count; k++ ) {
+		int result = sort->keys[k].type->compare( values1[k], values2[k] );
+		if ( result ) return sort->keys[k].descending ? -result : result;
+	}
+	return 0;
+}
+
+//Sort element positions by their keys, so elements with equal keys keep their order.
+static void
+sortKeyed( const KeyedSort* sort, size_t positions[], size_t buffer[], size_t n )
+{
+	mergeSortPositions( positions, buffer, n, compareKeyed, sort );
+}
+
+//-------------------------------------------------------------------------------
+//	Selection
+//-------------------------------------------------------------------------------
+
+/*	Introselect: Partition like the pattern-defeating quicksort, but continue only with the
+	side containing the nth position. Runs of elements equal to a former pivot are skipped as a
+	whole, bad pivots too often fall back to heap sort. Afterwards data[nth] is the element a
+	sort would put there, with no greater element before and no smaller one behind it.
+*/
+static void
+selectNth( void** data, size_t n, size_t nth, WElementCompare* compare )
+{
+	void** begin = data;
+	void** end = data+n;
+	void** target = data+nth;
+	int badAllowed = 1;
+	while ( n >> badAllowed ) badAllowed++;
+
+	while ( end - begin >= SortInsertionLimit ) {
+		size_t size = end - begin;
+		sortGeneric_sort3( begin+size/2, begin, end-1, compare );	//The median becomes the pivot.
+
+		if ( begin > data and not sortGeneric_less( begin[-1], *begin, compare )) {
+			void** equal = sortGeneric_partitionLeft( begin, end, compare );
+			if ( target <= equal ) return;		//All elements up to equal are the same.
+			begin = equal+1;
+			continue;
+		}
+
+		bool partitioned;
+		void** pivot = sortGeneric_partitionRight( begin, end, &partitioned, compare );
+		if ( pivot == target ) return;
+
+		size_t left = pivot - begin;
+		if ( (left < size/8 or size-left-1 < size/8) and --badAllowed == 0 ) {
+			sortGeneric_heapSort( begin, end, compare );
+			return;
+		}
+		if ( target < pivot )
+			end = pivot;
+		else
+			begin = pivot+1;
+	}
+	sortGeneric_insertion( begin, end, compare );
+}
+
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+//Inline elements are sorted by their addresses and then copied in the sorted order.
+static void**
+inlineAddresses( const WArray* array )
+{
+	void** elements = __wxmalloc( array->size * sizeof( void* ));
+	for ( size_t i = 0; i < array->size; i++ )
+		elements[i] = slotAt( array, i );
+	return elements;
+}
+
+static void
+placeInline( WArray* array, void** elements )
+{
+	size_t size = array->size;
+	size_t elementSize = array->elementSize;
+	char* sorted = __wxmalloc( size * elementSize );
+	for ( size_t i = 0; i < size; i++ )
+		memcpy( sorted + i*elementSize, elements[i], elementSize );
+	memcpy( slotAt( array, 0 ), sorted, size * elementSize );
+
+	free( sorted );
+	free( elements );
+}
+
+WArray*
+warray_sort( WArray* array )
+{
+   	assert( array );
+   	assert( array->type->compare );
+
+	return warray_sortBy( array, array->type->compare );
+}
+
+WArray*
+warray_sortBy( WArray* array, WElementCompare* compare )
 {
 	assert( array );
-	assert( warray_nonEmpty( array ));
+	assert( compare );
 
-	return warray_stealAt( array, 0 );
+	return warray_sortParallel( array, compare, array->size >= ParallelSortLimit ? 0 : 1 );
 }
 
-void*
-warray_stealLast( WArray* array )
+WArray*
+warray_sortParallel( WArray* array, WElementCompare* compare, size_t threads )
 {
 	assert( array );
-	assert( warray_nonEmpty( array ));
+	assert( compare );
 
-	return warray_stealAt( array, array->size-1 );
+	if ( not threads ) threads = defaultThreads();
+	if ( array->size > 1 ) {
+		if ( array->elementSize ) {
+			void** elements = inlineAddresses( array );
+			sortParallel( elements, array->size, compare, threads );
+			placeInline( array, elements );
+		}
+		else
+			sortParallel( array->data, array->size, compare, threads );
+	}
+	invalidateIndex( array );
+
+	assert( array );
+	assert( isSortedBy( array, compare ));
+	return checkArray( array );
 }
 
-void*
-warray_stealSample( WArray* array )
+WArray*
+warray_sortStable( WArray* array )
 {
-	assert( array );
-	assert( warray_nonEmpty( array ));
+   	assert( array );
+   	assert( array->type->compare );
 
-	return warray_stealAt( array, rand() % array->size );
+	return warray_sortStableBy( array, array->type->compare );
 }
 
 WArray*
-warray_removeAt( WArray* array, size_t position )
+warray_sortStableBy( WArray* array, WElementCompare* compare )
 {
 	assert( array );
-	assert( position < warray_size( array ));
-
-	assert( &array->data[position] );
-	array->type->delete( &array->data[position] );
-
-	if ( position < array->size-1 )
-		memmove( &array->data[position], &array->data[position+1], (array->size-position-1) * sizeof( void* ));
+	assert( compare );
 
-	array->size--;
+	if ( array->size > 1 ) {
+		if ( array->elementSize ) {
+			void** elements = inlineAddresses( array );
+			sortStable( elements, array->size, compare );
+			placeInline( array, elements );
+		}
+		else
+			sortStable( array->data, array->size, compare );
+	}
+	invalidateIndex( array );
 
 	assert( array );
+	assert( isSortedBy( array, compare ));
 	return checkArray( array );
 }
 
 WArray*
-warray_removeFirst( WArray* array )
+warray_sortByKey( WArray* array, WElementMap* extractKey, const WType* keyType, const void* keyData )
 {
 	assert( array );
-	assert( warray_nonEmpty( array ));
+	assert( extractKey );
+	assert( keyType and keyType->compare );
 
-	return warray_removeAt( array, 0 );
+	return warray_sortByKeys( array, 1, (WSortKey[]){{ extractKey, keyType, keyData, false }});
 }
 
 WArray*
-warray_removeLast( WArray* array )
+warray_sortByKeys( WArray* array, size_t count, const WSortKey keys[count] )
 {
 	assert( array );
-	assert( warray_nonEmpty( array ));
+	assert( count > 0 );
+	assert( keys );
+
+	size_t size = array->size;
+	if ( size < 2 ) return checkArray( array );
+
+	KeyedSort sort = { keys, count, __wxmalloc( size * count * sizeof( void* )) };
+	for ( size_t i = 0; i < size; i++ )
+		for ( size_t k = 0; k < count; k++ )
+			sort.values[i*count + k] = keys[k].key( elementAt( array, i ), keys[k].data );
+
+	size_t* positions = __wxmalloc( size * sizeof( size_t ));
+	size_t* buffer = __wxmalloc( size/2 * sizeof( size_t ));
+	for ( size_t i = 0; i < size; i++ )
+		positions[i] = i;
+	sortKeyed( &sort, positions, buffer, size );
+
+	//Undecorate: put the elements in the order of their keys.
+	void** elements = __wxmalloc( size * sizeof( void* ));
+	for ( size_t i = 0; i < size; i++ )
+		elements[i] = array->elementSize ? slotAt( array, positions[i] ) : array->data[positions[i]];
+	if ( array->elementSize )
+		placeInline( array, elements );
+	else {
+		memcpy( array->data, elements, size * sizeof( void* ));
+		free( elements );
+	}
+	invalidateIndex( array );
 
-	return warray_removeAt( array, array->size-1 );
-}
+	for ( size_t i = 0; i < size; i++ )
+		for ( size_t k = 0; k < count; k++ )
+			if ( keys[k].type->delete ) keys[k].type->delete( &sort.values[i*count + k] );
+	free( buffer );
+	free( positions );
+	free( sort.values );
 
-//-------------------------------------------------------------------------------
-//-------------------------------------------------------------------------------
+	assert( array );
+	assert( array->size == size );
+	return checkArray( array );
+}
 
-void
-warray_foreach( const WArray* array, WElementForeach* foreach, void* foreachData )
+WArray*
+warray_nthElement( WArray* array, size_t n )
 {
 	assert( array );
-	assert( foreach );
+	assert( array->type->compare );
+	assert( n < array->size );
 
-	for ( size_t i = 0; i < array->size; i++ )
-		foreach( array->data[i], foreachData );
+	WElementCompare* compare = array->type->compare;
+	if ( array->elementSize ) {
+		void** elements = inlineAddresses( array );
+		selectNth( elements, array->size, n, compare );
+		placeInline( array, elements );
+	}
+	else
+		selectNth( array->data, array->size, n, compare );
+	invalidateIndex( array );
+
+	assert( array );
+	assert( n == 0 or compare( warray_at( array, n-1 ), warray_at( array, n )) <= 0 );
+	assert( n+1 == array->size or compare( warray_at( array, n ), warray_at( array, n+1 )) <= 0 );
+	return checkArray( array );
 }
 
-void
-warray_foreachIndex( const WArray* array, WElementForeachIndex* foreach, void* foreachData )
+WArray*
+warray_partialSort( WArray* array, size_t k )
 {
 	assert( array );
-	assert( foreach );
+	assert( array->type->compare );
 
-	for ( size_t i = 0; i < array->size; i++ )
-		foreach( array->data[i], i, foreachData );
+	WElementCompare* compare = array->type->compare;
+	k = __wmin( k, array->size );
+	if ( k ) {
+		void** elements = array->elementSize ? inlineAddresses( array ) : array->data;
+		if ( k < array->size )
+			selectNth( elements, array->size, k, compare );	//The k smallest elements go first.
+		sortPointers( elements, k, compare );
+		if ( array->elementSize ) placeInline( array, elements );
+	}
+	invalidateIndex( array );
+
+	assert( array );
+	return checkArray( array );
 }
 
 WArray*
-warray_filter( const WArray* array, WElementCondition* filter, const void* filterData )
+warray_topK( const WArray* array, size_t k, WElementCompare* compare )
 {
 	assert( array );
-	assert( filter );
-
-	WArray* newArray = (WArray*)warray_new( array->capacity, array->type );
+	assert( compare );
 
-    for ( size_t i = 0; i < array->size; i++ ) {
-        if ( filter( array->data[i], filterData )) {
-			if ( array->data[i] )
-				newArray->data[newArray->size++] = array->type->clone( array->data[i] );
-			else
-				newArray->data[newArray->size++] = NULL;
+	//A max-heap of the k first elements seen so far, its root is the one to drop next.
+	k = __wmin( k, array->size );
+	void** heap = __wxmalloc( __wmax( k, 1 ) * sizeof( void* ));	//malloc( 0 ) may fail.
+	size_t count = 0;
+	for ( size_t i = 0; i < array->size; i++ ) {
+		void* element = elementAt( array, i );
+		if ( count < k ) {
+			heap[count++] = element;
+			if ( count == k )
+				for ( size_t j = k/2; j-- > 0; )
+					sortGeneric_siftDown( heap, j, k, compare );
 		}
-    }
+		else if ( k and compare( element, heap[0] ) < 0 ) {
+			heap[0] = element;
+			sortGeneric_siftDown( heap, 0, k, compare );
+		}
+	}
+	sortGeneric( heap, count, compare );
+
+	WArray* top = newArray( k, array->elementSize, array->type, array->allocator );
+	for ( size_t i = 0; i < count; i++ )
+		storeAt( top, top->size++, heap[i] );
+	free( heap );
 
-	assert( newArray );
-	assert( warray_size( newArray ) <= warray_size( array ));
-	assert( warray_all( newArray, filter, filterData ));
-	return checkArray( newArray );
+	assert( top );
+	assert( top->size == k );
+	return checkArray( top );
 }
 
-WArray*
-warray_reject( const WArray* array, WElementCondition* reject, const void* rejectData )
+//Keep the first of several equal elements using a hash set of the kept positions. O(n) expected.
+static void
+distinctByHash( WArray* array )
 {
-	assert( array );
-	assert( reject );
+	WElementHash* hash = array->type->hash;
+	WElementCompare* compare = array->type->compare;
 
-	WArray* newArray = (WArray*)warray_new( array->capacity, array->type );
+	size_t buckets = 16;
+	while ( buckets < 2 * array->size ) buckets *= 2;
+	size_t* kept = memset( __wxmalloc( buckets * sizeof( size_t )), 0, buckets * sizeof( size_t ));	//Position+1, 0 if empty
 
-    for ( size_t i = 0; i < array->size; i++ ) {
-        if ( not reject( array->data[i], rejectData )) {
-			if ( array->data[i] )
-				newArray->data[newArray->size++] = array->type->clone( array->data[i] );
-			else
-				newArray->data[newArray->size++] = NULL;
+	size_t write = 0;
+	for ( size_t read = 0; read < array->size; read++ ) {
+		const void* element = elementAt( array, read );
+		size_t bucket = hash( element ) & (buckets-1);
+		while ( kept[bucket] and compare( elementAt( array, kept[bucket]-1 ), element ) != 0 )
+			bucket = (bucket+1) & (buckets-1);
+
+		if ( kept[bucket] )		//A duplicate.
+			deleteAt( array, read );
+		else {
+			kept[bucket] = write+1;
+			if ( write != read ) copySlot( array, write, read );
+			write++;
 		}
-    }
+	}
 
-	assert( newArray );
-	assert( warray_size( newArray ) <= warray_size( array ));
-	assert( warray_none( newArray, reject, rejectData ));
-	return checkArray( newArray );
+	array->size = write;
+	free( kept );
 }
 
-WArray*
-warray_select( WArray* array, WElementCondition* filter, const void* filterData )
+//Keep the first of several equal elements by sorting their positions. O(n log n).
+static void
+distinctBySort( WArray* array )
 {
-	assert( array );
-	assert( filter );
+	size_t n = array->size;
+	size_t* positions = __wxmalloc( n * sizeof( size_t ));
+	size_t* buffer = __wxmalloc( n * sizeof( size_t ));
+	for ( size_t i = 0; i < n; i++ )
+		positions[i] = i;
 
-	size_t to = 0;
-    for ( size_t from = 0; from < array->size; from++ ) {
-        if ( filter( array->data[from], filterData ))
-			array->data[to++] = array->data[from];
+	sortPositions( array, positions, buffer, n );
+
+	//Mark the duplicates, runs of equal elements start with the first one.
+	bool* duplicate = memset( buffer, 0, n * sizeof( bool ));
+	size_t first = positions[0];
+	for ( size_t i = 1; i < n; i++ ) {
+		if ( array->type->compare( elementAt( array, first ), elementAt( array, positions[i] )) == 0 )
+			duplicate[positions[i]] = true;
+		else
+			first = positions[i];
+	}
+
+	size_t write = 0;
+	for ( size_t read = 0; read < n; read++ ) {
+		if ( duplicate[read] )
+			deleteAt( array, read );
 		else {
-			assert( &array->data[from] );
-			array->type->delete( &array->data[from] );
+			if ( write != read ) copySlot( array, write, read );
+			write++;
 		}
-    }
-
-    array->size = to;
+	}
 
-	assert( array );
-	assert( warray_all( array, filter, filterData ));
-	return checkArray( array );
+	array->size = write;
+	free( positions );
+	free( buffer );
 }
 
 WArray*
-warray_unselect( WArray* array, WElementCondition* filter, const void* filterData )
+warray_distinct( WArray* array)
 {
 	assert( array );
-	assert( filter );
+   	assert( array->type->compare );
 
-	size_t to = 0;
-    for ( size_t from = 0; from < array->size; from++ ) {
-        if ( !filter( array->data[from], filterData ))
-			array->data[to++] = array->data[from];
-		else {
-			assert( &array->data[from] );
-			array->type->delete( &array->data[from] );
-		}
-	}
+	if ( array->size < 2 ) return checkArray( array );
 
-    array->size = to;
+	if ( array->type->hash )
+		distinctByHash( array );
+	else
+		distinctBySort( array );
+	invalidateIndex( array );
 
 	assert( array );
-	assert( warray_none( array, filter, filterData ));
 	return checkArray( array );
 }
 
 WArray*
-warray_map( const WArray* array, WElementMap* map, const void* mapData, const WType* type )
+warray_concat( WArray* array1, const WArray* array2 )
 {
-	assert( array );
-	assert( map );
-
-	if ( not type ) type = wtypePtr;
-	WArray* newArray = warray_new( array->capacity, type );
-
-	for ( size_t i = 0; i < array->size; i++ )
-		newArray->data[i] = map( array->data[i], mapData );
+	assert( array1 );
+	assert( array2 );
+	assert( array1->type == array2->type && "Arrays to be concatenated must have the same element types." );
+	assert( array1->elementSize == array2->elementSize );
 
-    newArray->size = array->size;
+	size_t n = array2->size;
+	resize( array1, array1->size + n );
+	copyRun( array1, array1->size, array2, 0, n );
+	array1->size += n;
+	indexInserted( array1, array1->size-n, n );
 
-	assert( newArray );
-	assert( newArray->size == array->size );
-	assert( not type or newArray->type == type );
-    return checkArray( newArray );
+	assert( array1 );
+	return checkArray( array1 );
 }
 
-void*
-warray_reduce( const WArray* array, WElementReduce* reduce, const void* startValue, const WType* type )
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+
+bool
+warray_all( const WArray* array, WElementCondition* condition, const void* conditionData )
 {
 	assert( array );
-	assert( reduce );
-
-	if ( not type ) type = wtypePtr;
+	assert( condition && "Need a condition to check for." );
 
-	if ( array->size == 0 ) {
-		if ( startValue )
-			return type->clone( startValue );
-		else
-			return NULL;
+	for ( size_t i = 0; i < array->size; i++ ) {
+        if ( not condition( elementAt( array, i ), conditionData ))
+			return false;
 	}
 
-	void* reduction = reduce( array->data[0], startValue );
+	return true;
+}
 
-    for ( size_t i = 1; i < array->size; i++ ) {
-		void* newReduction = reduce( array->data[i], reduction );
-		assert( &reduction );
-		type->delete( &reduction );
-		reduction = newReduction;
+bool
+warray_any( const WArray* array, WElementCondition* condition, const void* conditionData )
+{
+	assert( array );
+	assert( condition && "Need a condition to check for." );
+
+	for ( size_t i = 0; i < array->size; i++ ) {
+        if ( condition( elementAt( array, i ), conditionData ))
+			return true;
 	}
 
-	return reduction;
+	return false;
 }
 
-size_t
-warray_count( const WArray* array, WElementCondition* condition, const void* conditionData )
+bool
+warray_none( const WArray* array, WElementCondition* condition, const void* conditionData )
 {
 	assert( array );
-	assert( condition );
-
-	size_t count = 0;
+	assert( condition && "Need a condition to check for." );
 
-    for ( size_t i = 0; i < array->size; i++ ) {
-		if ( condition( array->data[i], conditionData ))
-			count++;
-    }
+	for ( size_t i = 0; i < array->size; i++ ) {
+        if ( condition( elementAt( array, i ), conditionData ))
+			return false;
+	}
 
-	assert( count <= array->size );
-	return count;
+	return true;
 }
 
-ssize_t
-warray_index( const WArray* array, const void* element )
+bool
+warray_one( const WArray* array, WElementCondition* condition, const void* conditionData )
 {
 	assert( array );
-	assert( array->type->compare );
-
-	WElementCompare* compare = array->type->compare;
+	assert( condition && "Need a condition to check for." );
 
+	size_t counter = 0;
 	for ( size_t i = 0; i < array->size; i++ ) {
-		if ( compare( element, array->data[i] ) == 0 ) {
-			assert( i <= array->size );
-			return i;
-		}
+        if ( condition( elementAt( array, i ), conditionData ))
+			counter++;
 	}
 
-	return -1;
+	return counter == 1;
 }
 
-ssize_t
-warray_rindex( const WArray* array, const void* element )
+//-------------------------------------------------------------------------------
+//	Lazy queries
+//-------------------------------------------------------------------------------
+
+enum {
+	QueryStageCapacity = 4
+};
+
+typedef enum QueryStageKind {
+	QueryFilter,
+	QueryReject,
+	QueryMap,
+} QueryStageKind;
+
+typedef struct QueryStage {
+	QueryStageKind kind;
+	WElementCondition* condition;
+	WElementMap* map;
+	const void* data;
+	const WType* type;		//Of the mapped elements
+} QueryStage;
+
+struct WQuery {
+	const WArray* array;
+	QueryStage* stages;
+	size_t size;
+	size_t capacity;
+	const WType* type;		//Of the resulting elements, NULL for the source elements
+};
+
+/*	Receives the elements yielded by a query. An owned element must be taken over or deleted
+	with query->type. Returns false to stop the query.
+*/
+typedef bool QuerySink( WQuery* query, void* element, bool owned, void* sinkData );
+
+static WQuery*
+addStage( WQuery* query, QueryStage stage )
 {
-	assert( array );
-	assert( array->type->compare );
+	if ( query->size == query->capacity ) {
+		query->capacity *= 2;
+		query->stages = __wxrealloc( query->stages, query->capacity * sizeof( QueryStage ));
+	}
+	query->stages[query->size++] = stage;
+	if ( stage.kind == QueryMap )
+		query->type = stage.type;
+	return query;
+}
 
-	WElementCompare* compare = array->type->compare;
+//Put every element through all stages and pass what comes out to the sink.
+static void
+runQuery( WQuery* query, QuerySink* sink, void* sinkData )
+{
+	const WArray* array = query->array;
+	for ( size_t i = 0; i < array->size; i++ ) {
+		void* element = elementAt( array, i );
+		const WType* type = NULL;	//Of the element if owned
+
+		bool passed = true;
+		for ( size_t k = 0; k < query->size and passed; k++ ) {
+			QueryStage* stage = &query->stages[k];
+			if ( stage->kind == QueryMap ) {
+				void* mapped = stage->map( element, stage->data );
+				if ( type ) type->delete( &element );
+				element = mapped;
+				type = stage->type;
+			}
+			else
+				passed = stage->condition( element, stage->data ) == (stage->kind == QueryFilter);
+		}
 
-	for ( size_t i = array->size-1; i < array->size; i-- ) {
-		if ( compare( element, array->data[i] ) == 0 ) {
-			assert( i <= array->size );
-			return i;
+		if ( not passed ) {
+			if ( type ) type->delete( &element );
+			continue;
 		}
+		if ( not sink( query, element, type != NULL, sinkData ))
+			break;
 	}
+	wquery_delete( &query );
+}
 
-	return -1;
+static bool
+collectSink( WQuery* query, void* element, bool owned, void* sinkData )
+{
+	(void)query;
+	WArray* collected = sinkData;
+	if ( owned )
+		warray_pushLast( collected, element );	//Take the mapped element over.
+	else
+		warray_append( collected, element );
+	return true;
 }
 
-//Helper for warray_toString()
-static char*
-str_cat3( const char* str1, const char* str2, const char* str3 )
+typedef struct QueryReduction {
+	WElementReduce* reduce;
+	const WType* type;
+	void* reduction;
+	bool started;
+} QueryReduction;
+
+static bool
+reduceSink( WQuery* query, void* element, bool owned, void* sinkData )
 {
-	assert( str1 );
-	assert( str2 );
-	assert( str3 );
+	QueryReduction* reduction = sinkData;
+	void* newReduction = reduction->reduce( element, reduction->reduction );
+	if ( reduction->started )
+		reduction->type->delete( &reduction->reduction );
+	reduction->reduction = newReduction;
+	reduction->started = true;
+	if ( owned ) query->type->delete( &element );
+	return true;
+}
+
+typedef struct QueryFold {
+	WElementFold* fold;
+	void* accumulator;
+	const void* data;
+} QueryFold;
 
-    size_t size1 = strlen( str1 );
-    size_t size2 = strlen( str2 );
-    size_t size3 = strlen( str3 );
+static bool
+foldSink( WQuery* query, void* element, bool owned, void* sinkData )
+{
+	QueryFold* fold = sinkData;
+	fold->fold( element, fold->accumulator, fold->data );
+	if ( owned ) query->type->delete( &element );
+	return true;
+}
 
-	char* newStr = __wxmalloc( size1 + size2 + size3 + 1 );
+static bool
+countSink( WQuery* query, void* element, bool owned, void* count )
+{
+	if ( owned ) query->type->delete( &element );
+	(*(size_t*)count)++;
+	return true;
+}
 
-	memcpy( newStr,				str1, size1 );
-	memcpy( newStr+size1,		str2, size2 );
-	memcpy( newStr+size1+size2, str3, size3 );
+static bool
+anySink( WQuery* query, void* element, bool owned, void* any )
+{
+	if ( owned ) query->type->delete( &element );
+	*(bool*)any = true;
+	return false;
+}
 
-	newStr[size1+size2+size3] = 0;
-	assert( newStr );
-	return newStr;
+static bool
+firstSink( WQuery* query, void* element, bool owned, void* first )
+{
+	*(void**)first = owned ? element : copyElement( query->array, element );
+	return false;
 }
 
-char*
-warray_toString( const WArray* array, const char delimiter[] )
+WQuery*
+warray_query( const WArray* array )
 {
 	assert( array );
-	assert( delimiter );
-	assert( array->type->toString );
 
-	if ( not array->size ) return __wstr_dup( "" );
-
-	WElementToString* toString = array->type->toString;
-	char* string = array->data[0] ? toString( array->data[0] ) : __wstr_dup( "(NULL)" );	//The first element without delimiter
-	assert( string );
-
-	for ( size_t i = 1; i < array->size; i++ ) {	//Concatenate current string, delimiter and next element.
-		char* elementStr = array->data[i] ? toString( array->data[i] ) : __wstr_dup( "(NULL)" );
-		assert( elementStr );
-		char* temp = str_cat3( string, delimiter, elementStr );
-		free( string );
-		free( elementStr );
-		string = temp;
-	}
+	WQuery* query = __wxnew( WQuery, .array = array, .capacity = QueryStageCapacity );
+	query->stages = __wxmalloc( query->capacity * sizeof( QueryStage ));
 
-	assert( string );
-	return string;
+	assert( query );
+	return query;
 }
 
-WArray*
-warray_fromString( const char string[], const char delimiter[], const WType* targetType )
+WQuery*
+wquery_filter( WQuery* query, WElementCondition* condition, const void* conditionData )
 {
-	assert( string );
-	assert( delimiter and delimiter[0] );
-	assert( targetType );
-	assert( targetType->clone and targetType->delete and targetType->fromString );
-
-	WArray* array = warray_new( 0, targetType );
-
-	char* newString = __wstr_dup( string );
-	char* context = NULL;
-	char* token = __wstr_sep_r( newString, delimiter, &context );
+	assert( query );
+	assert( condition );
 
-	while ( token ) {
-		void* element;
-		if ( strcmp( token, "(NULL)" ) != 0 ) {
-			element = targetType->fromString( token );
-			assert( element );
-			warray_append( array, element );
-			targetType->delete( &element );
-		}
-		else
-			warray_append( array, NULL );
-		token = __wstr_sep_r( NULL, delimiter, &context );
-	}
+	return addStage( query, (QueryStage){ QueryFilter, .condition = condition, .data = conditionData });
+}
 
-	free( newString );
+WQuery*
+wquery_reject( WQuery* query, WElementCondition* condition, const void* conditionData )
+{
+	assert( query );
+	assert( condition );
 
-	assert( array );
-	return checkArray( array );
+	return addStage( query, (QueryStage){ QueryReject, .condition = condition, .data = conditionData });
 }
 
-int
-warray_compare( const WArray* array1, const WArray* array2 )
+WQuery*
+wquery_map( WQuery* query, WElementMap* map, const void* mapData, const WType* targetType )
 {
-	assert( array1 );
-	assert( array2 );
-	assert( array1->type == array2->type && "Can't compare arrays of different type." );
-	assert( array1->type->compare != NULL && "Need a comparison function." );
+	assert( query );
+	assert( map );
 
-	//Setup some variables to save avoid unnecessary pointer accesses in the loop.
-	WElementCompare* compare = array1->type->compare;
-	void** data1 = array1->data;
-	void** data2 = array2->data;
+	if ( not targetType ) targetType = wtypePtr;
+	return addStage( query, (QueryStage){ QueryMap, .map = map, .data = mapData, .type = targetType });
+}
 
-	//Compare all elements with each other until one array ends or a difference is found.
-	for ( size_t i = 0; i < array1->size and i < array2->size; i++ ) {
-		int result = compare( data1[i], data2[i] );
-		if ( result ) return result;
-	}
+void
+wquery_delete( WQuery** queryPtr )
+{
+	if ( not queryPtr or not *queryPtr ) return;
 
-	//The compared elements were equal, now compare the sizes.
-	return (ssize_t)array1->size - (ssize_t)array2->size;
+	free( (*queryPtr)->stages );
+	free( *queryPtr );
+	*queryPtr = NULL;
 }
 
-//-------------------------------------------------------------------------------
-//-------------------------------------------------------------------------------
-
-const void*
-warray_min( const WArray* array )
+WArray*
+wquery_collect( WQuery* query )
 {
-	assert( array );
-	assert( warray_nonEmpty( array ));
-	assert( array->type->compare && "Need a comparison method!" );
-
-	WElementCompare* compare = array->type->compare;
+	assert( query );
 
-    void* minimum = array->data[0];
-    for ( size_t i = 1; i < array->size; i++ ) {
-		if ( compare( array->data[i], minimum ) < 0 )
-			minimum = array->data[i];
-    }
+	const WArray* array = query->array;
+	WArray* collected = query->type
+		? warray_new( 0, query->type )
+		: newArray( 0, array->elementSize, array->type, array->allocator );
+	runQuery( query, collectSink, collected );
 
-	return minimum;
+	assert( collected );
+	return checkArray( collected );
 }
 
-const void*
-warray_max( const WArray* array )
+void*
+wquery_reduce( WQuery* query, WElementReduce* reduce, const void* startValue, const WType* targetType )
 {
-	assert( array );
-	assert( warray_nonEmpty( array ));
-	assert( array->type->compare && "Need a comparison method!" );
-
-	WElementCompare* compare = array->type->compare;
+	assert( query );
+	assert( reduce );
 
-    void* maximum = array->data[0];
-    for ( size_t i = 1; i < array->size; i++ ) {
-		if ( compare( array->data[i], maximum ) > 0 )
-			maximum = array->data[i];
-    }
+	if ( not targetType ) targetType = wtypePtr;
+	QueryReduction reduction = { reduce, targetType, (void*)startValue, false };
+	runQuery( query, reduceSink, &reduction );
 
-	return maximum;
+	if ( not reduction.started )
+		return startValue ? targetType->clone( startValue ) : NULL;
+	return reduction.reduction;
 }
 
-ssize_t
-warray_search( const WArray* array, WElementCompare* compare, const void* key )
+void*
+wquery_fold( WQuery* query, WElementFold* fold, void* accumulator, const void* foldData )
 {
-	assert( array );
-	assert( compare && "Need a comparison function!" );
-
-	for ( size_t i = 0; i < array->size; i++ ) {
-		if ( compare( key, array->data[i] ) == 0 )
-			return i;
-	}
+	assert( query );
+	assert( fold );
 
-	return -1;
+	runQuery( query, foldSink, &(QueryFold){ fold, accumulator, foldData });
+	return accumulator;
 }
 
-// Helper struct to get both the bsearch comparison function and the key into our actual comparison function.
-typedef struct ElementComparer {
-	WElementCompare* compare;
-	const void*		element;
-}ElementComparer;
-
-static inline int
-compareKeyWithElement( const void* key, const void* element )
+size_t
+wquery_count( WQuery* query )
 {
-	//Extract the comparison function and the key.
-	const ElementComparer* keyComparer = key;
-	//bsearch gives us a pointer to the element, we deliver the element itself to the client comparison function.
-	return keyComparer->compare( keyComparer->element, *(void**)element );
+	assert( query );
+
+	size_t count = 0;
+	runQuery( query, countSink, &count );
+	return count;
 }
 
-ssize_t
-warray_bsearch( const WArray* array, WElementCompare* compare, const void* key )
+bool
+wquery_any( WQuery* query )
 {
-	assert( array );
-	assert( compare && "Need a comparison function!" );
-
-	if ( not array->size ) return -1;
+	assert( query );
 
-	ElementComparer keyComparer = { .compare = compare, .element = key };
-	void** element = bsearch( &keyComparer, array->data, array->size, sizeof(void*), compareKeyWithElement );
-	if ( not element ) return -1;
+	bool any = false;
+	runQuery( query, anySink, &any );
+	return any;
+}
 
-	assert( element >= array->data );
-	assert( element < &array->data[array->size] );
+void*
+wquery_first( WQuery* query )
+{
+	assert( query );
 
-	size_t position = element - array->data;	//This gives the real position, not the byte difference!
-	assert( position <= array->size );
-	assert( compare( key, warray_at( array, position )) == 0 );
-	return position;
+	void* first = WElementNotFound;
+	runQuery( query, firstSink, &first );
+	return first;
 }
 
 //-------------------------------------------------------------------------------
+//	Selections
 //-------------------------------------------------------------------------------
 
-WArray*
-warray_reverse( WArray* array )
-{
-	assert( array );
-
-	ssize_t front = 0;
-	ssize_t back = array->size-1;
+enum {
+	SelectionWordBits = 64
+};
 
-	while ( front < back ) {
-		__wswapPtr( array->data[front], array->data[back] );
-		front++;
-		back--;
-	}
+static inline size_t
+selectionWords( size_t size )
+{
+	return (size + SelectionWordBits-1) / SelectionWordBits;
+}
 
-	assert( array );
-	return checkArray( array );
+static inline unsigned
+countBits( uint64_t word )
+{
+#ifdef __GNUC__
+	return __builtin_popcountll( word );
+#else
+	unsigned count = 0;
+	for ( ; word; word &= word-1 )
+		count++;
+	return count;
+#endif
 }
 
-WArray*
-warray_shuffle( WArray* array )
+//Position of the lowest set bit, word must not be 0.
+static inline unsigned
+lowestBit( uint64_t word )
 {
-	assert( array );
+#ifdef __GNUC__
+	return __builtin_ctzll( word );
+#else
+	unsigned bit = 0;
+	for ( ; not (word & 1); word >>= 1 )
+		bit++;
+	return bit;
+#endif
+}
 
-	for ( size_t i = 0; i < array->size; i++ ) {
-        size_t position = rand() % array->size;
-        __wswapPtr( array->data[i], array->data[position] );
-	}
+//Run the statements for every selected position in ascending order. word_ is the index of its bit word.
+#define FOREACH_SELECTED( selection, position, ... )									\
+	for ( size_t word_ = 0; word_ < selectionWords( (selection)->size ); word_++ )		\
+		for ( uint64_t bits_ = (selection)->bits[word_]; bits_; bits_ &= bits_-1 ) {	\
+			size_t position = word_ * SelectionWordBits + lowestBit( bits_ );			\
+			__VA_ARGS__																	\
+		}
 
-	assert( array );
-	return checkArray( array );
+WSelection*
+wselection_new( size_t size )
+{
+	size_t words = selectionWords( size );
+	WSelection* selection = __wxmalloc( sizeof( WSelection ) + words * sizeof( uint64_t ));
+	selection->size = size;
+	memset( selection->bits, 0, words * sizeof( uint64_t ));
+
+	assert( selection );
+	assert( selection->size == size );
+	return selection;
 }
 
-WArray*
-warray_compact( WArray* array )
+void
+wselection_delete( WSelection** selectionPtr )
 {
-	assert( array );
+	if ( not selectionPtr or not *selectionPtr ) return;
 
-	size_t write = 0;
-    for ( size_t read = 0; read < array->size; read++ ) {
-		void* value = array->data[read];
-		if ( value ) array->data[write++] = value;
-    }
+	free( *selectionPtr );
+	*selectionPtr = NULL;
+}
 
-    array->size = write;
+WSelection*
+wselection_set( WSelection* selection, size_t position, bool selected )
+{
+	assert( selection );
+	assert( position < selection->size );
 
-	assert( array );
-	assert( not warray_contains( array, NULL ));
-	return checkArray( array );
+	uint64_t bit = (uint64_t)1 << position % SelectionWordBits;
+	if ( selected )
+		selection->bits[position / SelectionWordBits] |= bit;
+	else
+		selection->bits[position / SelectionWordBits] &= ~bit;
+	return selection;
 }
 
-static bool
-isSorted( const WArray* array )
+bool
+wselection_contains( const WSelection* selection, size_t position )
 {
-	if ( not array->size ) return true;
-
-	WElementCompare* compare = array->type->compare;
-	for ( size_t j = 0; j < array->size-1; j++ ) {
-		if ( compare( warray_at( array, j ), warray_at( array, j+1 )) == 1 )
-			return false;
-	}
+	assert( selection );
+	assert( position < selection->size );
 
-	return true;
+	return selection->bits[position / SelectionWordBits] >> position % SelectionWordBits & 1;
 }
 
-WArray*
-warray_sort( WArray* array )
+size_t
+wselection_count( const WSelection* selection )
 {
-   	assert( array );
-   	assert( array->type->compare );
+	assert( selection );
 
-	return warray_sortBy( array, array->type->compare );
-}
+	size_t count = 0;
+	for ( size_t i = 0; i < selectionWords( selection->size ); i++ )
+		count += countBits( selection->bits[i] );
 
-/*	Here we define a helper function converting the void** pointers from qsort to void* elements.
-	callback functions. The downside: we get a dependency from C11 to remain thread-safe.
-	This helps keeping the API uniform, we always provide void* elements to the client. The only
-	working alternative would require a GNU non-standard nested function inside warray_sortBy().
-*/
-_Thread_local WElementCompare* sortCompare;
-static int compareTwoElements( const void* element1, const void* element2 ) {	//qsort delivers void**
-	return sortCompare( *(void**)element1, *(void**)element2 );					//we deliver void* instead
+	assert( count <= selection->size );
+	return count;
 }
 
-WArray*
-warray_sortBy( WArray* array, WElementCompare* compare )
+WSelection*
+wselection_and( WSelection* selection, const WSelection* other )
 {
-	assert( array );
-	assert( compare );
+	assert( selection );
+	assert( other );
+	assert( selection->size == other->size );
 
-	sortCompare = compare;
-	qsort( array->data, array->size, sizeof( void* ), compareTwoElements );
-
-	assert( array );
-	assert( isSorted( array ));
-	return checkArray( array );
+	for ( size_t i = 0; i < selectionWords( selection->size ); i++ )
+		selection->bits[i] &= other->bits[i];
+	return selection;
 }
 
-WArray*
-warray_distinct( WArray* array)
+WSelection*
+wselection_or( WSelection* selection, const WSelection* other )
 {
-	assert( array );
-   	assert( array->type->compare );
+	assert( selection );
+	assert( other );
+	assert( selection->size == other->size );
 
-	WElementCompare* compare = array->type->compare;
+	for ( size_t i = 0; i < selectionWords( selection->size ); i++ )
+		selection->bits[i] |= other->bits[i];
+	return selection;
+}
 
-	for ( size_t i = 0; i < array->size; i++ ) {
-		for ( size_t j = i+1; j < array->size; j++ ) {
-			if ( compare( array->data[i], array->data[j] ) == 0 ) {
-				warray_removeAt( array, i );
-				i--;
-				break;
-			}
-		}
-	}
+WSelection*
+wselection_not( WSelection* selection )
+{
+	assert( selection );
 
-	assert( array );
-	return checkArray( array );
+	size_t words = selectionWords( selection->size );
+	for ( size_t i = 0; i < words; i++ )
+		selection->bits[i] = ~selection->bits[i];
+
+	//Keep the bits past the last position cleared.
+	if ( selection->size % SelectionWordBits )
+		selection->bits[words-1] &= ((uint64_t)1 << selection->size % SelectionWordBits) - 1;
+	return selection;
 }
 
 WArray*
-warray_concat( WArray* array1, const WArray* array2 )
+wselection_positions( const WSelection* selection )
 {
-	assert( array1 );
-	assert( array2 );
-	assert( array1->type == array2->type && "Arrays to be concatenated must have the same element types." );
+	assert( selection );
 
-	for ( size_t i = 0; i < array2->size; i++ )
-		warray_append( array1, array2->data[i] );
+	WArray* positions = newArray( wselection_count( selection ), 0, wtypeInt, wallocatorDefault );
+	FOREACH_SELECTED( selection, position,
+		positions->data[positions->size++] = (void*)position;
+	)
 
-	assert( array1 );
-	return checkArray( array1 );
+	assert( positions );
+	assert( positions->size == wselection_count( selection ));
+	return checkArray( positions );
 }
 
-//-------------------------------------------------------------------------------
-//-------------------------------------------------------------------------------
-
-bool
-warray_all( const WArray* array, WElementCondition* condition, const void* conditionData )
+WSelection*
+warray_filterIndices( const WArray* array, WElementCondition* condition, const void* conditionData )
 {
 	assert( array );
-	assert( condition && "Need a condition to check for." );
+	assert( condition );
 
-	for ( size_t i = 0; i < array->size; i++ ) {
-        if ( not condition( array->data[i], conditionData ))
-			return false;
-	}
+	WSelection* selection = wselection_new( array->size );
+	for ( size_t i = 0; i < array->size; i++ )
+		if ( condition( elementAt( array, i ), conditionData ))
+			selection->bits[i / SelectionWordBits] |= (uint64_t)1 << i % SelectionWordBits;
 
-	return true;
+	assert( selection );
+	assert( selection->size == array->size );
+	return selection;
 }
 
-bool
-warray_any( const WArray* array, WElementCondition* condition, const void* conditionData )
+WSelection*
+warray_filterSelected( const WArray* array, WSelection* selection, WElementCondition* condition, const void* conditionData )
 {
 	assert( array );
-	assert( condition && "Need a condition to check for." );
+	assert( selection );
+	assert( selection->size == array->size );
+	assert( condition );
 
-	for ( size_t i = 0; i < array->size; i++ ) {
-        if ( condition( array->data[i], conditionData ))
-			return true;
-	}
+	FOREACH_SELECTED( selection, position,
+		if ( not condition( elementAt( array, position ), conditionData ))
+			selection->bits[word_] &= ~((uint64_t)1 << position % SelectionWordBits);
+	)
 
-	return false;
+	return selection;
 }
 
-bool
-warray_none( const WArray* array, WElementCondition* condition, const void* conditionData )
+WArray*
+warray_gather( const WArray* array, const WSelection* selection )
 {
 	assert( array );
-	assert( condition && "Need a condition to check for." );
+	assert( selection );
+	assert( selection->size == array->size );
 
-	for ( size_t i = 0; i < array->size; i++ ) {
-        if ( condition( array->data[i], conditionData ))
-			return false;
-	}
+	WArray* gathered = newArray( wselection_count( selection ), array->elementSize, array->type, array->allocator );
+	FOREACH_SELECTED( selection, position,
+		storeAt( gathered, gathered->size++, elementAt( array, position ));
+	)
 
-	return true;
+	assert( gathered );
+	assert( gathered->size == wselection_count( selection ));
+	return checkArray( gathered );
 }
 
-bool
-warray_one( const WArray* array, WElementCondition* condition, const void* conditionData )
+void
+warray_foreachSelected( const WArray* array, const WSelection* selection, WElementForeachIndex* foreach, void* foreachData )
 {
 	assert( array );
-	assert( condition && "Need a condition to check for." );
-
-	size_t counter = 0;
-	for ( size_t i = 0; i < array->size; i++ ) {
-        if ( condition( array->data[i], conditionData ))
-			counter++;
-	}
+	assert( selection );
+	assert( selection->size == array->size );
+	assert( foreach );
 
-	return counter == 1;
+	FOREACH_SELECTED( selection, position,
+		foreach( elementAt( array, position ), position, foreachData );
+	)
 }
 
 //-------------------------------------------------------------------------------
@@ -22,6 +22,7 @@
 
 #include "wcollection.h"
 #include <stdbool.h>			//bool
+#include <stdint.h>				//uint64_t
 #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
 	#include <sys/types.h>		//ssize_t on POSIX systems
 #else
@@ -32,6 +33,9 @@
 //	Types and constants
 //------------------------------------------------------------
 
+typedef struct WArrayIndex WArrayIndex;
+typedef struct WArrayPrefixes WArrayPrefixes;
+
 /**	The array type. Access it only through the warray_xyz() functions except
 	reading the explicitly public fields.
 */
@@ -40,6 +44,13 @@ typedef struct WArray {
 	size_t			capacity;		///<Public read-only, the maximum number of elements before the array must grow
 	const WType*	type;			//Private, do not directly access it. Pointer to the element methods
 	void**			data;			//Private, do not directly access it.
+	size_t			front;			//Private, do not directly access it. Number of free slots before the first element
+	size_t			elementSize;	//Private, do not directly access it. Byte size of inline elements, 0 for pointer elements
+	const WAllocator* allocator;	//Private, do not directly access it. Memory source for the array and its elements
+	WArena*			arena;			//Private, do not directly access it. Element memory for types with the arena flag
+	WArrayIndex*	index;			//Private, do not directly access it. Optional hash index for lookups
+	WArrayPrefixes*	prefixes;		//Private, do not directly access it. Optional string prefixes for comparisons
+	max_align_t		embedded[];		//Private, do not directly access it. Small data block allocated together with the header
 }WArray;
 
 /** Pointer to a struct describing methods for elements that are arrays themselves.
@@ -59,7 +70,9 @@ extern const WType* wtypeArray;
 
 /**	Create a new empty array with the appropriate methods for the element type.
 
-	@param capacity The initial element capacity. If 0 is given, the initial capacity is set to 100.
+	@param capacity The initial element capacity. If 0 is given, the initial capacity is set to 8.
+	Small arrays keep their data in the same allocation as the array structure and move it to
+	a separate block only when they grow.
 	@param type Pointer to a structure with element methods to be used in array functions.
 		If NULL is passed, the elements are treated as raw pointers and the methods set in
 		\ref wtypePtr are used. If a type is given, but the compare, fromString or toString
@@ -75,7 +88,7 @@ extern const WType* wtypeArray;
 	//allocated for the element itself, only for the pointer. The element does not get
 	//deallocated when it is removed from the array.
 	WArray* a1 = warray_new(		//Create an array
-		0,							//with the default capacity (100)
+		0,							//with the default capacity (8)
 		NULL						//and the default element type (wtypePtr, i.e. raw void*)
 	);
 	WArray* a2 = warray_new(
@@ -112,6 +125,67 @@ extern const WType* wtypeArray;
 WArray*
 warray_new( size_t capacity, const WType* type );
 
+/**	Create a new empty array storing fixed-size elements by value.
+
+	The elements are not kept as pointers to separately allocated objects, but are copied
+	byte by byte into one contiguous data block. So a million doubles or small records need a
+	single allocation and can be scanned without pointer chasing.
+
+	All array functions work on inline arrays too. They pass the address of the element inside
+	the data block to the element methods and return it from functions like warray_at(). Such
+	pointers are invalidated by the next modifying array function.
+
+	Inline elements must be self-contained, i.e. must not own resources like allocated strings.
+	The type's clone() and delete() methods are never called, elements are copied with memcpy()
+	and simply dropped when removed. NULL elements put into the array become zeroed elements.
+	Functions returning an element to the caller, like warray_stealAt() or warray_cloneAt(), return
+	a malloc()ed copy of elementSize bytes. Elements passed with warray_pushAt() and friends are
+	copied and then freed.
+
+	@param capacity The initial element capacity. If 0 is given, the default capacity is used.
+	@param elementSize The byte size of one element, e.g. sizeof( double ).
+	@param type Element methods getting a pointer to the element, e.g. wtypeDouble or custom methods
+		for a record type. wtypeInt, wtypeStr and wtypePtr don't fit, because they expect the
+		element value in the pointer itself. If NULL is passed, the elements are raw bytes without
+		compare(), fromString() and toString() methods. Only the compare(), fromString() and toString()
+		fields are used.
+	@return The new array
+	@pre elementSize > 0
+
+	Example:
+	\code
+	typedef struct Point { double x, y; }Point;
+
+	WArray* points = warray_newInline( 0, sizeof( Point ), NULL );
+	warray_append( points, &(Point){ 1.0, 2.0 });
+	const Point* point = warray_at( points, 0 );
+	\endcode
+*/
+WArray*
+warray_newInline( size_t capacity, size_t elementSize, const WType* type );
+
+/**	Create a new empty array getting all its memory from the given allocator.
+
+	The array structure and its data block are allocated with the allocator. Elements are
+	cloned and deleted with it too, if the type provides the cloneWith() and deleteWith()
+	methods like wtypeStr and wtypeDouble do. Otherwise the elements are cloned with the
+	type's clone() method as usual.
+
+	Elements leaving the array, e.g. by warray_stealAt(), are converted to ordinary clone()
+	allocated elements, so the caller can release them as usual. The other way round elements
+	passed with warray_pushAt() and friends are cloned into the allocator and then deleted.
+
+	@param capacity The initial element capacity. If 0 is given, the default capacity is used.
+	@param type The element type like in warray_new().
+	@param allocator The allocator to be used. The array only keeps the pointer, so the allocator
+		must be permanently accessible while the array exists.
+	@return The new array
+	@pre allocator != NULL
+	@pre If type->cloneWith is given, type->deleteWith may not be NULL.
+*/
+WArray*
+warray_newWithAllocator( size_t capacity, const WType* type, const WAllocator* allocator );
+
 /**	Clone the given array by cloning the elements with the array's clone() method.
 
 	@param array
@@ -224,6 +298,8 @@ warray_insert( WArray* array, size_t position, const void* element );
 	ownership of the copy. The given element remains untouched, so allocated elements can be
 	passed, but also literals.
 
+	The insertion point is found with a binary search, so the array must already be sorted.
+
 	@param array The array to be modified in place.
 	@param element The element to be added. NULL elements are allowed.
 	@return The modified array, allowing the chaining of function calls.
@@ -358,6 +434,67 @@ warray_set_n( WArray* array, size_t position, size_t n, void* const elements[n]
 WArray*
 warray_insert_n( WArray* array, size_t position, size_t n, void* const elements[n] );
 
+/**	Insert one or several elements into the array and pass their ownership.
+
+	Unlike warray_insert_n() no copies are made, the elements must be properly allocated like the
+	array's clone() method would do it. Inline arrays copy the bytes and free() the elements.
+
+	@param array The array to be modified in place.
+	@param position May be greater than the current size. A possible gap
+		between the last current and the first new element is filled with
+		NULL elements.
+	@param n The number of elements to be added. Must match with the actual
+		number of elements in the elements array.
+	@param elements A list of n elements gifted to the array. NULL elements are allowed. All
+		entries equal NULL afterwards.
+	@return The modified array, allowing the chaining of function calls.
+	@pre array != NULL
+	@pre n > 0
+	@pre elements != NULL
+*/
+WArray*
+warray_pushInsert_n( WArray* array, size_t position, size_t n, void* elements[n] );
+
+/**	Set or update one or several elements in the array and pass their ownership.
+
+	Like warray_pushInsert_n(), but replaces the elements from position on like warray_set_n().
+
+	@param array The array to be modified in place.
+	@param position May be greater than the current size.
+	@param n The number of elements to be set.
+	@param elements A list of n elements gifted to the array. All entries equal NULL afterwards.
+	@return The modified array, allowing the chaining of function calls.
+	@pre array != NULL
+	@pre n > 0
+	@pre elements != NULL
+*/
+WArray*
+warray_pushSet_n( WArray* array, size_t position, size_t n, void* elements[n] );
+
+/**	Insert one or several elements into a sorted array, so that it keeps the ascending element
+	order according to the array->type->compare() method.
+
+	The new elements are sorted first and then merged with the array elements in one pass,
+	which is cheaper than calling warray_insertSorted() for every element. New elements are
+	placed behind equal elements already in the array.
+
+	The array makes copies of the given elements with the array's clone() method and takes full
+	ownership of the copies. The given elements remains untouched, so allocated elements can be
+	passed, but also literals.
+
+	@param array The sorted array to be modified in place.
+	@param n The number of elements to be added. Must match with the actual
+		number of elements in the elements array.
+	@param elements A list of n elements to be added in any order. NULL elements are allowed.
+	@return The modified array, allowing the chaining of function calls.
+	@pre array != NULL
+	@pre array->type->compare != NULL
+	@pre n > 0
+	@pre elements != NULL
+*/
+WArray*
+warray_insertSortedMany( WArray* array, size_t n, void* const elements[n] );
+
 /**	Append the elements of an array to another array.
 
 	The array makes copies of the 2nd array's elements with the array's clone() method and takes full
@@ -631,6 +768,56 @@ warray_bsearch( const WArray* array, WElementCompare* compare, const void* key )
 static inline bool
 warray_contains( const WArray* array, const void* element ) { return warray_index( array, element ) >= 0; }
 
+/**	Maintain a hash index of the elements, so that warray_index(), warray_rindex() and
+	warray_contains() take O(1) expected time instead of comparing all elements.
+
+	Appending, prepending, setting and removing elements at both ends of the array update the
+	index in O(1). Other modifications like sorting or inserting in the middle mark the index
+	as outdated and it gets rebuilt with the next lookup. The index is not cloned with the array.
+
+	@param array
+	@return The array
+	@pre array != NULL
+	@pre array->type->compare != NULL
+	@pre array->type->hash != NULL
+*/
+WArray*
+warray_enableIndex( WArray* array );
+
+/**	Drop the hash index built by warray_enableIndex(). If the array has no index, this is a no-op.
+
+	@param array
+	@return The array
+	@pre array != NULL
+*/
+WArray*
+warray_disableIndex( WArray* array );
+
+/**	Keep the first eight bytes of every string as a number in a side array, so warray_index(),
+	warray_rindex(), warray_contains() and warray_bsearch() with wtypeStr_compare() mostly compare
+	numbers and read a string only if its prefix matches. Saves cache misses on large arrays.
+
+	The prefixes are computed on the first lookup and kept up to date afterwards: Changes forget
+	the prefixes from their position on, appending elements costs nothing until the next lookup.
+	A hash index of warray_enableIndex() takes precedence in warray_index().
+
+	@param array
+	@return The array
+	@pre array != NULL
+	@pre array is no inline array and array->type->compare == wtypeStr_compare
+*/
+WArray*
+warray_enablePrefixes( WArray* array );
+
+/**	Drop the prefixes kept by warray_enablePrefixes(). If the array has none, this is a no-op.
+
+	@param array
+	@return The array
+	@pre array != NULL
+*/
+WArray*
+warray_disablePrefixes( WArray* array );
+
 //------------------------------------------------------------
 //	Comparing arrays
 //------------------------------------------------------------
@@ -675,14 +862,15 @@ warray_equal( const WArray* array1, const WArray* array2 ){ return warray_compar
 
 /**	Join the elements to a string.
 
-	Each element is stringified with the array->toString() method given at warray_new().
+	Each element is stringified with the array->toStrBuf() method given at warray_new(), which
+	appends the text directly, or else with the array->toString() method.
 
 	@param array
 	@param delimiter Separator string inserted between the strings of two elements
 	@return Allocated string, either of stringified elements or "", if the array is empty
 	@pre array != NULL
 	@pre delimiters != NULL
-	@pre array->type->toString != NULL
+	@pre array->type->toString != NULL or array->type->toStrBuf != NULL
 */
 char*
 warray_toString( const WArray* array, const char delimiter[] );
@@ -704,6 +892,21 @@ warray_toString( const WArray* array, const char delimiter[] );
 WArray*
 warray_fromString( const char string[], const char delimiter[], const WType* targetType );
 
+/**	Create an array of strings from a string without allocating every token.
+
+	Like warray_fromString() with wtypeStr, but the string is copied only once into the arena
+	of a wtypeStrArena array and split in place. The elements point into this copy, so
+	splitting big texts costs a single allocation instead of several per token.
+
+	@param string
+	@param delimiter
+	@return array of type wtypeStrArena
+	@pre string != NULL
+	@pre delimiters != NULL and delimiters[0] != 0
+*/
+WArray*
+warray_splitView( const char string[], const char delimiter[] );
+
 //------------------------------------------------------------
 //	Query basic array data.
 //------------------------------------------------------------
@@ -866,6 +1069,108 @@ warray_map( const WArray* array, WElementMap* map, const void* mapData, const WT
 void*
 warray_reduce( const WArray* array, WElementReduce* reduce, const void* startValue, const WType* targetType );
 
+/**	Fold all elements into an accumulator owned by the caller.
+
+	Unlike warray_reduce() no intermediate results are allocated: the fold function changes
+	the accumulator in place, so folding into counters, string buffers or other containers
+	takes linear time.
+
+	Example:
+	\code
+	void appendWord( const void* element, void* buf, const void* separator )
+	{
+		wstrbuf_printf( buf, "%s%s", (char*)element, (char*)separator );
+	}
+
+	...
+
+	WStrBuf* buf = warray_fold( words, appendWord, wstrbuf_new( 0 ), ", " );
+	\endcode
+
+	@param array
+	@param fold Called with every element in order.
+	@param accumulator Passed to every fold call. May be NULL.
+	@param foldData Passed to every fold call. May be NULL.
+	@return The accumulator
+	@pre array != NULL
+	@pre fold != NULL
+*/
+void*
+warray_fold( const WArray* array, WElementFold* fold, void* accumulator, const void* foldData );
+
+/**	Like warray_filter(), but the condition is called from several threads at once.
+
+	The array is split into chunks, which are filtered in the pool of wpool_default(). The
+	chunk results are then put together in order, so the output array equals the one of
+	warray_filter().
+
+	@param array
+	@param condition Called from several threads at once.
+	@param conditionData Passed to the condition function. May be NULL.
+	@param threads The most threads working at once, 0 for one per thread of wpool_default().
+		With 1 everything runs in the calling thread.
+	@return The output array. Is never NULL.
+	@pre array != NULL
+	@pre condition != NULL
+*/
+WArray*
+warray_filterParallel( const WArray* array, WElementCondition* condition, const void* conditionData, size_t threads );
+
+/**	Like warray_reject(), but the condition is called from several threads at once,
+	see warray_filterParallel().
+
+	@param array
+	@param condition Called from several threads at once.
+	@param conditionData Passed to the condition function. May be NULL.
+	@param threads The most threads working at once, 0 for one per thread of wpool_default().
+	@return The output array. Is never NULL.
+	@pre array != NULL
+	@pre condition != NULL
+*/
+WArray*
+warray_rejectParallel( const WArray* array, WElementCondition* condition, const void* conditionData, size_t threads );
+
+/**	Like warray_map(), but the map function is called from several threads at once in the
+	pool of wpool_default(). The output array equals the one of warray_map().
+
+	@param array
+	@param map Called from several threads at once.
+	@param mapData Optional argument passed to the map function.
+	@param targetType The type of the mapped elements, wtypePtr if NULL.
+	@param threads The most threads working at once, 0 for one per thread of wpool_default().
+	@return A new array of the same size as the given array with the mapped elements.
+	@pre array != NULL
+	@pre map != NULL
+	@post returnValue->size == array->size
+*/
+WArray*
+warray_mapParallel( const WArray* array, WElementMap* map, const void* mapData, const WType* targetType, size_t threads );
+
+/**	Reduce all elements to a single value using several threads.
+
+	The array is cut into chunks of 256 elements, which are reduced like warray_reduce() does
+	it in the pool of wpool_default(), at most threads of them at once. The first chunk starts with startValue, the others with
+	a NULL intermediate. The chunk results are then combined from left to right. As the chunks
+	only depend on the array size, the result is the same for any number of threads, which
+	matters for floating point sums for instance. Arrays of up to 256 elements are reduced
+	exactly like warray_reduce() does it.
+
+	@param array
+	@param reduce Called from several threads at once. Must accept a NULL intermediate.
+	@param combine Combines the results of two neighbouring parts. Must be associative.
+	@param startValue The intermediate value passed with the first element. May be NULL.
+	@param targetType The type of the intermediate values and the result, wtypePtr if NULL.
+	@param threads The most threads working at once, 0 for one per thread of wpool_default().
+		With 1 everything runs in the calling thread.
+	@return The reduction, or a clone of startValue for an empty array.
+	@pre array != NULL
+	@pre reduce != NULL
+	@pre combine != NULL
+*/
+void*
+warray_reduceParallel( const WArray* array, WElementReduce* reduce, WElementCombine* combine, const void* startValue,
+	const WType* targetType, size_t threads );
+
 //------------------------------------------------------------
 //	Do stuff with the elements.
 //------------------------------------------------------------
@@ -895,7 +1200,11 @@ warray_shuffle( WArray* array );
 WArray*
 warray_compact( WArray* array );
 
-/**	Sort the array elements in place using qsort() with the array comparison function.
+/**	Sort the array elements in place with the array comparison function.
+
+	The sort is a pattern-defeating quicksort, which is not stable. The comparison functions of
+	wtypeInt, wtypeDouble and wtypeStr are recognized: large arrays are radix sorted, small ones
+	sorted with inlined comparisons.
 
 	@param array
 	@return The sorted array
@@ -905,8 +1214,10 @@ warray_compact( WArray* array );
 WArray*
 warray_sort( WArray* array );
 
-//TODO: Pass an optional data argument to the comparison function?
-/**	Sort the array elements in place using qsort() with the given comparison function.
+/**	Sort the array elements in place with the given comparison function, see warray_sort().
+
+	Arrays of a million elements and more are sorted with warray_sortParallel() on all
+	processors, so the comparison function must be safe to call from several threads.
 
 	@param array
 	@param compare
@@ -917,10 +1228,159 @@ warray_sort( WArray* array );
 WArray*
 warray_sortBy( WArray* array, WElementCompare* compare );
 
+/**	Sort the array elements in place with the given comparison function using several threads.
+
+	Parts of the array are sorted in parallel like warray_sortBy() does it and then merged
+	pairwise, every merge again split between the threads. The sorted array equals the one of
+	warray_sortBy(), but elements comparing equal may end up in a different order. Each task
+	gets at least 16384 elements, smaller arrays are sorted in the calling thread. The tasks
+	run in the shared pool of wpool_default(). Without C11 thread support (__STDC_NO_THREADS__)
+	the work is done serially.
+
+	@param array
+	@param compare Called from several threads at once.
+	@param threads The number of parallel tasks, 0 for one per thread of wpool_default().
+	@return The sorted array
+	@pre array != NULL
+	@pre compare != NULL
+*/
+WArray*
+warray_sortParallel( WArray* array, WElementCompare* compare, size_t threads );
+
+/**	Sort the array elements in place with the array comparison function, keeping the order of
+	equal elements.
+
+	The sort is a timsort-like merge sort of the natural runs in the array. An already sorted
+	array is recognized in one pass with n-1 comparisons, appending a few elements to a sorted
+	array costs little more. The worst case is O(n log n) with a buffer of n/2 elements.
+
+	@param array
+	@return The sorted array
+	@pre array != NULL
+	@pre array->type->compare != NULL
+*/
+WArray*
+warray_sortStable( WArray* array );
+
+/**	Sort the array elements in place with the given comparison function, keeping the order of
+	equal elements, see warray_sortStable().
+
+	@param array
+	@param compare
+	@return The sorted array
+	@pre array != NULL
+	@pre compare != NULL
+*/
+WArray*
+warray_sortStableBy( WArray* array, WElementCompare* compare );
+
+/**	One key of a multi-key sort with warray_sortByKeys().
+*/
+typedef struct WSortKey {
+	WElementMap* key;		///<Computes the key of an element, allocated like type->clone() does it.
+	const WType* type;		///<Compares and deletes the keys.
+	const void* data;		///<Passed to key() as mapData. May be NULL.
+	bool descending;		///<Reverse the order of this key.
+} WSortKey;
+
+/**	Sort the array elements in place by keys derived from them, keeping the order of elements
+	with equal keys.
+
+	Every key is computed once per element, sorted and deleted with the keyType afterwards, so
+	expensive keys like lower-cased strings cost O(n) key computations instead of O(n log n).
+	keyData passes context to the key function, e.g. a field to sort by.
+
+	\code
+	void* lowerCity( const void* person, const void* data ) {
+		return toLower( ((Person*)person)->city );		//A malloc()ed copy
+	}
+	warray_sortByKey( persons, lowerCity, wtypeStr, NULL );
+	\endcode
+
+	@param array
+	@param extractKey Returns the key of an element.
+	@param keyType The keys' type with compare() and delete().
+	@param keyData Passed to extractKey() as mapData. May be NULL.
+	@return The sorted array
+	@pre array != NULL
+	@pre extractKey != NULL
+	@pre keyType != NULL and keyType->compare != NULL
+*/
+WArray*
+warray_sortByKey( WArray* array, WElementMap* extractKey, const WType* keyType, const void* keyData );
+
+/**	Sort the array elements in place by a chain of keys, see warray_sortByKey(). Elements with
+	equal first keys are ordered by the second key and so on. Elements with all keys equal keep
+	their order.
+
+	\code
+	warray_sortByKeys( persons, 2, (WSortKey[]){
+		{ personCity, wtypeStr },
+		{ personAge, wtypeInt, .descending = true }
+	});
+	\endcode
+
+	@param array
+	@param count The number of keys.
+	@param keys The keys from the most significant one on.
+	@return The sorted array
+	@pre array != NULL
+	@pre count > 0
+	@pre keys != NULL
+*/
+WArray*
+warray_sortByKeys( WArray* array, size_t count, const WSortKey keys[count] );
+
+/**	Move the element, which a sort would put at position n, to this position. No element before
+	it is greater and no element behind it is less, otherwise the order is unspecified.
+
+	The selection is an introselect in O(n) expected time, e.g. the median of an array is
+	warray_at( warray_nthElement( array, array->size/2 ), array->size/2 ).
+
+	@param array
+	@param n The position of interest.
+	@return The modified array
+	@pre array != NULL
+	@pre array->type->compare != NULL
+	@pre n < array->size
+*/
+WArray*
+warray_nthElement( WArray* array, size_t n );
+
+/**	Sort only the k least elements to the front of the array, the order of the rest is
+	unspecified. Takes O(n + k log k) instead of O(n log n) for a full sort.
+
+	@param array
+	@param k The number of elements to sort, all of them if k >= array->size.
+	@return The modified array
+	@pre array != NULL
+	@pre array->type->compare != NULL
+*/
+WArray*
+warray_partialSort( WArray* array, size_t k );
+
+/**	Return a new array with copies of the k first elements in the order of the comparison
+	function, sorted. The array remains untouched. Takes O(n log k) with a heap of k elements,
+	so the 100 largest of millions of elements need no sort of the whole array.
+
+	@param array
+	@param k The number of elements, all of them if k >= array->size.
+	@param compare Pass a reversed comparison to get the k greatest elements.
+	@return A new array of min( k, array->size ) elements
+	@pre array != NULL
+	@pre compare != NULL
+*/
+WArray*
+warray_topK( const WArray* array, size_t k, WElementCompare* compare );
+
 /** Remove all identical elements using the comparison function from the
-	element type. It is undefined which of the duplicate elements remains afterwards.
+	element type. The first of the duplicate elements remains and the order of the
+	remaining elements is kept.
 	If the array contains several NULL elements they get reduced to one NULL value too.
 
+	With a hash() method in the element type this takes O(n) expected time, otherwise
+	the element positions get sorted in O(n log n).
+
 	@param array
 	@return The array without duplicate elements
 	@pre array != NULL
@@ -990,6 +1450,309 @@ warray_none( const WArray* array, WElementCondition* condition, const void* cond
 bool
 warray_one( const WArray* array, WElementCondition* condition, const void* conditionData );
 
+//------------------------------------------------------------
+//	Lazy queries
+//------------------------------------------------------------
+
+/**	A lazy pipeline of filter and map stages over an array. The stages are only recorded until
+	a terminal function like wquery_collect() or wquery_reduce() runs them in a single pass:
+	every element goes through all stages before the next one is read, so no intermediate
+	arrays are built. Mapped values are deleted as soon as the next stage is done with them.
+
+	The terminal functions delete the query. The array must stay unchanged until then.
+
+	Example:
+	\code
+	//Sum the lengths of all long words without an array of words or lengths in between.
+	size_t total = (size_t)wquery_reduce(
+		wquery_map( wquery_filter( warray_query( words ), isLongWord, NULL ), wordLength, NULL, wtypeInt ),
+		addLengths, NULL, wtypeInt );
+	\endcode
+*/
+typedef struct WQuery WQuery;
+
+/**	Start a lazy query over the array elements.
+
+	@param array The source array. Must outlive the query and stay unchanged.
+	@return A query without stages, yielding the array elements.
+	@pre array != NULL
+*/
+WQuery*
+warray_query( const WArray* array );
+
+/**	Add a stage passing on only the elements meeting the condition.
+
+	@param query
+	@param condition
+	@param conditionData Passed to the condition function. May be NULL.
+	@return The query
+	@pre query != NULL
+	@pre condition != NULL
+*/
+WQuery*
+wquery_filter( WQuery* query, WElementCondition* condition, const void* conditionData );
+
+/**	Add a stage passing on only the elements not meeting the condition.
+
+	@param query
+	@param condition
+	@param conditionData Passed to the condition function. May be NULL.
+	@return The query
+	@pre query != NULL
+	@pre condition != NULL
+*/
+WQuery*
+wquery_reject( WQuery* query, WElementCondition* condition, const void* conditionData );
+
+/**	Add a stage mapping each element to a new element, see warray_map().
+
+	@param query
+	@param map Its return value must be allocated the way targetType->clone() does it.
+	@param mapData Passed to the map function. May be NULL.
+	@param targetType The type of the mapped elements, wtypePtr if NULL.
+	@return The query
+	@pre query != NULL
+	@pre map != NULL
+*/
+WQuery*
+wquery_map( WQuery* query, WElementMap* map, const void* mapData, const WType* targetType );
+
+/**	Delete a query without running it. If NULL is passed, this is a no-op.
+
+	@param queryPtr After the deletion the query pointer is set to NULL.
+*/
+void
+wquery_delete( WQuery** queryPtr );
+
+/**	Run the query and put the resulting elements in a new array.
+
+	Without map stages the array has the type, element size and allocator of the source array
+	and holds copies of the elements. Otherwise it is of the type of the last map stage and
+	takes the mapped elements over.
+
+	@param query Deleted afterwards.
+	@return The new array. Is never NULL.
+	@pre query != NULL
+*/
+WArray*
+wquery_collect( WQuery* query );
+
+/**	Run the query and reduce the resulting elements like warray_reduce() does it.
+
+	@param query Deleted afterwards.
+	@param reduce
+	@param startValue The intermediate value passed with the first element. May be NULL.
+	@param targetType The type of the intermediate values and the result, wtypePtr if NULL.
+	@return The reduction, or a clone of startValue if the query yields no elements.
+	@pre query != NULL
+	@pre reduce != NULL
+*/
+void*
+wquery_reduce( WQuery* query, WElementReduce* reduce, const void* startValue, const WType* targetType );
+
+/**	Run the query and fold the resulting elements into the accumulator, see warray_fold().
+
+	@param query Deleted afterwards.
+	@param fold
+	@param accumulator Passed to every fold call. May be NULL.
+	@param foldData Passed to every fold call. May be NULL.
+	@return The accumulator
+	@pre query != NULL
+	@pre fold != NULL
+*/
+void*
+wquery_fold( WQuery* query, WElementFold* fold, void* accumulator, const void* foldData );
+
+/**	Run the query and count the resulting elements.
+
+	@param query Deleted afterwards.
+	@pre query != NULL
+*/
+size_t
+wquery_count( WQuery* query );
+
+/**	Run the query until it yields the first element.
+
+	@param query Deleted afterwards.
+	@return true if the query yields any element.
+	@pre query != NULL
+*/
+bool
+wquery_any( WQuery* query );
+
+/**	Run the query until it yields the first element and return it.
+
+	@param query Deleted afterwards.
+	@return The first resulting element, owned by the caller: a copy of the source element as
+		warray_cloneAt() makes it, or the mapped element. WElementNotFound if the query yields
+		no elements.
+	@pre query != NULL
+*/
+void*
+wquery_first( WQuery* query );
+
+//------------------------------------------------------------
+//	Selections
+//------------------------------------------------------------
+
+/**	A set of array positions stored as a bitmap, e.g. the positions of the elements meeting
+	a condition. Selections of the same size can be combined with wselection_and(),
+	wselection_or() and wselection_not() before any element is copied.
+
+	Example:
+	\code
+	//Count the long words without a vowel at the start without cloning any word.
+	WSelection* selection = warray_filterIndices( words, isLongWord, NULL );
+	WSelection* vowels = warray_filterIndices( words, startsWithVowel, NULL );
+	size_t count = wselection_count( wselection_and( selection, wselection_not( vowels )));
+	\endcode
+*/
+typedef struct WSelection {
+	size_t		size;		///<Public read-only, the number of positions, selected or not
+	uint64_t	bits[];		//Private, do not directly access it. One bit per position
+}WSelection;
+
+/**	Create a selection with no position selected.
+
+	@param size The number of positions.
+	@return The new selection
+*/
+WSelection*
+wselection_new( size_t size );
+
+/**	Free the selection. If NULL is passed, this is a no-op.
+
+	@param selectionPtr After the deletion the selection pointer is set to NULL.
+*/
+void
+wselection_delete( WSelection** selectionPtr );
+
+/**	Select or unselect a position.
+
+	@param selection
+	@param position
+	@param selected
+	@return The selection
+	@pre selection != NULL
+	@pre position < selection->size
+*/
+WSelection*
+wselection_set( WSelection* selection, size_t position, bool selected );
+
+/**	Return true if the position is selected.
+
+	@param selection
+	@param position
+	@pre selection != NULL
+	@pre position < selection->size
+*/
+bool
+wselection_contains( const WSelection* selection, size_t position );
+
+/**	Return the number of selected positions.
+
+	@pre selection != NULL
+*/
+size_t
+wselection_count( const WSelection* selection );
+
+/**	Keep only the positions selected in both selections.
+
+	@param selection Changed in place.
+	@param other
+	@return The selection
+	@pre selection != NULL
+	@pre other != NULL
+	@pre selection->size == other->size
+*/
+WSelection*
+wselection_and( WSelection* selection, const WSelection* other );
+
+/**	Add the positions selected in the other selection.
+
+	@param selection Changed in place.
+	@param other
+	@return The selection
+	@pre selection != NULL
+	@pre other != NULL
+	@pre selection->size == other->size
+*/
+WSelection*
+wselection_or( WSelection* selection, const WSelection* other );
+
+/**	Select exactly the positions not selected before.
+
+	@param selection Changed in place.
+	@return The selection
+	@pre selection != NULL
+*/
+WSelection*
+wselection_not( WSelection* selection );
+
+/**	Return the selected positions in ascending order as a compact array of type wtypeInt.
+
+	@param selection
+	@return The new array of positions
+	@pre selection != NULL
+*/
+WArray*
+wselection_positions( const WSelection* selection );
+
+/**	Select the positions of all elements meeting a condition. Unlike warray_filter() no element
+	is copied.
+
+	@param array
+	@param condition
+	@param conditionData Passed to the condition function. May be NULL.
+	@return A new selection of array->size positions
+	@pre array != NULL
+	@pre condition != NULL
+*/
+WSelection*
+warray_filterIndices( const WArray* array, WElementCondition* condition, const void* conditionData );
+
+/**	Unselect the positions of the selected elements not meeting a condition. The condition is
+	only called for selected elements, so chained filters get cheaper with every step.
+
+	@param array
+	@param selection Changed in place.
+	@param condition
+	@param conditionData Passed to the condition function. May be NULL.
+	@return The selection
+	@pre array != NULL
+	@pre selection != NULL
+	@pre selection->size == array->size
+	@pre condition != NULL
+*/
+WSelection*
+warray_filterSelected( const WArray* array, WSelection* selection, WElementCondition* condition, const void* conditionData );
+
+/**	Copy the selected elements in a new array of the same type and no more capacity than needed.
+
+	@param array
+	@param selection
+	@return The new array. Is never NULL.
+	@pre array != NULL
+	@pre selection != NULL
+	@pre selection->size == array->size
+*/
+WArray*
+warray_gather( const WArray* array, const WSelection* selection );
+
+/**	Call the function for every selected element in ascending order of the positions.
+
+	@param array
+	@param selection
+	@param foreach Called with the element and its position in the array.
+	@param foreachData Passed to the foreach function. May be NULL.
+	@pre array != NULL
+	@pre selection != NULL
+	@pre selection->size == array->size
+	@pre foreach != NULL
+*/
+void
+warray_foreachSelected( const WArray* array, const WSelection* selection, WElementForeachIndex* foreach, void* foreachData );
+
 //------------------------------------------------------------
 
 #endif
@@ -57,6 +57,8 @@
 */
 typedef struct WArrayNamespace {
 	WArray* 	(*new)		(size_t capacity, const WType* type);
+	WArray* 	(*newInline)(size_t capacity, size_t elementSize, const WType* type);
+	WArray* 	(*newWithAllocator)(size_t capacity, const WType* type, const WAllocator* allocator);
     WArray* 	(*clone)	(const WArray* array);
 	void		(*delete)	(WArray** array);
 	WArray*		(*clear)	(WArray* array);
@@ -67,12 +69,15 @@ typedef struct WArrayNamespace {
 	WArray* 	(*set)		(WArray* array, size_t, const void* element);
 	WArray* 	(*insert)	(WArray* array, size_t, const void* element);
 	WArray*		(*insertSorted)(WArray* array, const void* element);
+	WArray*		(*insertSortedMany)(WArray* array, size_t n, void* const elements[n]);
 	WArray*		(*addToSet)	(WArray* array, const void* element);
 
 	WArray*		(*append_n)	(WArray* array, size_t n, void* const elements[n]);
 	WArray*		(*prepend_n)(WArray* array, size_t n, void* const elements[n]);
 	WArray*		(*set_n)	(WArray* array, size_t position, size_t n, void* const elements[n]);
 	WArray*		(*insert_n)	(WArray* array, size_t position, size_t n, void* const elements[n]);
+	WArray*		(*pushInsert_n)(WArray* array, size_t position, size_t n, void* elements[n]);
+	WArray*		(*pushSet_n)(WArray* array, size_t position, size_t n, void* elements[n]);
 
 	const void* (*at)		(const WArray* array, size_t position);
 	const void* (*first)	(const WArray* array);
@@ -100,6 +105,20 @@ typedef struct WArrayNamespace {
 	WArray* 	(*reject)	(const WArray* array, WElementCondition* filter, const void* filterData );
 	WArray* 	(*map)		(const WArray* array, WElementMap*, const void*, const WType* type );
 	void*		(*reduce)	(const WArray* array, WElementReduce*, const void*, const WType* type );
+	void*		(*fold)		(const WArray* array, WElementFold*, void* accumulator, const void* foldData );
+	WArray* 	(*filterParallel)(const WArray* array, WElementCondition* filter, const void* filterData, size_t threads );
+	WArray* 	(*rejectParallel)(const WArray* array, WElementCondition* filter, const void* filterData, size_t threads );
+	WArray* 	(*mapParallel)(const WArray* array, WElementMap*, const void*, const WType* type, size_t threads );
+	void*		(*reduceParallel)(const WArray* array, WElementReduce*, WElementCombine*, const void*, const WType* type,
+					size_t threads );
+
+	WQuery*		(*query)	(const WArray* array);
+	WSelection*	(*filterIndices)(const WArray* array, WElementCondition* condition, const void* conditionData);
+	WSelection*	(*filterSelected)(const WArray* array, WSelection* selection, WElementCondition* condition,
+					const void* conditionData);
+	WArray*		(*gather)	(const WArray* array, const WSelection* selection);
+	void		(*foreachSelected)(const WArray* array, const WSelection* selection, WElementForeachIndex* foreach,
+					void* foreachData);
 
 	void		(*foreach)	(const WArray* array, WElementForeach* foreach, void* foreachData);
 	void		(*foreachIndex)(const WArray* array, WElementForeachIndex* foreach, void* foreachData);
@@ -113,16 +132,29 @@ typedef struct WArrayNamespace {
 	ssize_t		(*bsearch)	(const WArray* array, WElementCompare* compare, const void* key);
 	bool		(*contains)	(const WArray* array, const void* element);
 	size_t		(*count)	(const WArray* array, WElementCondition*, const void* conditionData);
+	WArray*		(*enableIndex)(WArray* array);
+	WArray*		(*disableIndex)(WArray* array);
+	WArray*		(*enablePrefixes)(WArray* array);
+	WArray*		(*disablePrefixes)(WArray* array);
 
 	WArray*		(*reverse)	(WArray* array);
 	WArray*		(*compact)	(WArray* array);
 	WArray*		(*sort)		(WArray* array);
 	WArray*		(*sortBy)	(WArray* array, WElementCompare* compare);
+	WArray*		(*sortParallel)(WArray* array, WElementCompare* compare, size_t threads);
+	WArray*		(*sortStable)(WArray* array);
+	WArray*		(*sortStableBy)(WArray* array, WElementCompare* compare);
+	WArray*		(*sortByKey)(WArray* array, WElementMap* extractKey, const WType* keyType, const void* keyData);
+	WArray*		(*sortByKeys)(WArray* array, size_t count, const WSortKey keys[count]);
+	WArray*		(*nthElement)(WArray* array, size_t n);
+	WArray*		(*partialSort)(WArray* array, size_t k);
+	WArray*		(*topK)		(const WArray* array, size_t k, WElementCompare* compare);
 	WArray*		(*distinct)	(WArray* array);
 	WArray*		(*shuffle)	(WArray* array);
 
 	char*		(*toString)	(const WArray* array, const char delimiter[]);
 	WArray*		(*fromString)(const char string[], const char delimiter[], const WType* targetType );
+	WArray*		(*splitView)(const char string[], const char delimiter[]);
 	int			(*compare) 	(const WArray* array1, const WArray* array2);
 	bool		(*equal)	(const WArray* array1, const WArray* array2);
 }WArrayNamespace;
@@ -132,6 +164,8 @@ typedef struct WArrayNamespace {
 #define warrayNamespace					\
 {										\
 	.new = warray_new,					\
+	.newInline = warray_newInline,		\
+	.newWithAllocator = warray_newWithAllocator,\
 	.clone = warray_clone,				\
 	.delete = warray_delete,			\
 	.clear = warray_clear,				\
@@ -142,11 +176,14 @@ typedef struct WArrayNamespace {
 	.set = warray_set,					\
 	.insert = warray_insert,			\
 	.insertSorted = warray_insertSorted,\
+	.insertSortedMany = warray_insertSortedMany,\
 \
 	.append_n = warray_append_n,		\
 	.prepend_n = warray_prepend_n,		\
 	.set_n = warray_set_n,				\
 	.insert_n = warray_insert_n,		\
+	.pushInsert_n = warray_pushInsert_n,\
+	.pushSet_n = warray_pushSet_n,		\
 \
 	.at = warray_at,					\
 	.first = warray_first,				\
@@ -174,6 +211,17 @@ typedef struct WArrayNamespace {
 	.reject = warray_reject,			\
 	.map = warray_map,					\
 	.reduce = warray_reduce,			\
+	.fold = warray_fold,				\
+	.filterParallel = warray_filterParallel,\
+	.rejectParallel = warray_rejectParallel,\
+	.mapParallel = warray_mapParallel,	\
+	.reduceParallel = warray_reduceParallel,\
+\
+	.query = warray_query,				\
+	.filterIndices = warray_filterIndices,\
+	.filterSelected = warray_filterSelected,\
+	.gather = warray_gather,			\
+	.foreachSelected = warray_foreachSelected,\
 \
 	.foreach = warray_foreach,			\
 	.foreachIndex = warray_foreachIndex,\
@@ -184,16 +232,29 @@ typedef struct WArrayNamespace {
 	.search = warray_search,			\
 	.contains = warray_contains,		\
 	.count = warray_count,				\
+	.enableIndex = warray_enableIndex,	\
+	.disableIndex = warray_disableIndex,\
+	.enablePrefixes = warray_enablePrefixes,\
+	.disablePrefixes = warray_disablePrefixes,\
 \
 	.reverse = warray_reverse,			\
 	.compact = warray_compact,			\
 	.sort = warray_sort,				\
 	.sortBy = warray_sortBy,			\
+	.sortParallel = warray_sortParallel,\
+	.sortStable = warray_sortStable,	\
+	.sortStableBy = warray_sortStableBy,\
+	.sortByKey = warray_sortByKey,		\
+	.sortByKeys = warray_sortByKeys,	\
+	.nthElement = warray_nthElement,	\
+	.partialSort = warray_partialSort,	\
+	.topK = warray_topK,				\
 	.distinct = warray_distinct,		\
 	.shuffle = warray_shuffle,			\
 \
 	.toString = warray_toString,		\
 	.fromString = warray_fromString,	\
+	.splitView = warray_splitView,		\
 	.compare = warray_compare,			\
 	.equal = warray_equal,				\
 }
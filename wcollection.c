@@ -15,13 +15,23 @@
     along with Workhorse Array.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#define _GNU_SOURCE		//sched_setaffinity() for pinned pool threads
 #include "wcollection.h"
 #include <assert.h>		//assert()
 #include <iso646.h>		//and, or, not
 #include <string.h>
 #include <stdarg.h>		//va_copy() etc.
+#include <stdint.h>		//uint64_t, uintptr_t
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>		//sysconf()
+#ifndef __STDC_NO_THREADS__
+#include <threads.h>	//thrd_create(), mtx_lock(), cnd_wait() etc.
+#include <stdatomic.h>	//atomic_size_t
+#endif
+#ifdef __linux__
+#include <sched.h>		//sched_setaffinity()
+#endif
 
 //---------------------------------------------------------------------------------
 //	WCollection memory management and helpers
@@ -34,10 +44,40 @@ __wdie( const char* text )
 	abort();
 }
 
+static void*
+mallocAlloc( void* context, size_t size )
+{
+	(void)context;
+	return malloc( size );
+}
+
+static void*
+mallocRealloc( void* context, void* pointer, size_t oldSize, size_t newSize )
+{
+	(void)context;
+	(void)oldSize;
+	return realloc( pointer, newSize );
+}
+
+static void
+mallocFree( void* context, void* pointer )
+{
+	(void)context;
+	free( pointer );
+}
+
+const WAllocator* wallocatorDefault = &(WAllocator){
+	.alloc = mallocAlloc,
+	.realloc = mallocRealloc,
+	.free = mallocFree,
+};
+
 void*
-__wxmalloc( size_t size )
+wallocator_alloc( const WAllocator* allocator, size_t size )
 {
-	void* ptr = malloc( size );
+	assert( allocator );
+
+	void* ptr = allocator->alloc( allocator->context, size );
 	if ( ptr ) return ptr;
 
 	__wdie( "Out of memory." );
@@ -45,15 +85,184 @@ __wxmalloc( size_t size )
 }
 
 void*
-__wxrealloc( void* pointer, size_t size )
+wallocator_realloc( const WAllocator* allocator, void* pointer, size_t oldSize, size_t newSize )
 {
-	void* ptr = realloc( pointer, size );
+	assert( allocator );
+
+	if ( not pointer ) return wallocator_alloc( allocator, newSize );
+
+	void* ptr = allocator->realloc( allocator->context, pointer, oldSize, newSize );
 	if ( ptr ) return ptr;
 
 	__wdie( "Out of memory." );
 	return NULL;
 }
 
+void
+wallocator_free( const WAllocator* allocator, void* pointer )
+{
+	assert( allocator );
+
+	if ( pointer ) allocator->free( allocator->context, pointer );
+}
+
+//---------------------------------------------------------------------------------
+//	Arenas
+//---------------------------------------------------------------------------------
+
+enum ArenaParameters {
+	ArenaMinChunkSize	= 4096,
+	ArenaMaxChunkSize	= 1024 * 1024,
+	ArenaAlignment		= _Alignof( max_align_t ),
+};
+
+typedef struct ArenaChunk {
+	struct ArenaChunk*	previous;
+	size_t				size;
+	max_align_t			data[];
+}ArenaChunk;
+
+struct WArena {
+	WAllocator			allocator;	//View on the arena, returned by warena_allocator()
+	const WAllocator*	backing;
+	ArenaChunk*			chunk;		//The current chunk, the older ones are linked via previous
+	char*				next;		//Free memory in the current chunk
+	char*				end;
+};
+
+//Round the size up, so the next allocation is aligned for any type again.
+static inline size_t
+arenaRound( size_t size )
+{
+	return (size + ArenaAlignment - 1) / ArenaAlignment * ArenaAlignment;
+}
+
+static void*
+arenaAlloc( void* context, size_t size )
+{
+	return warena_alloc( context, size );
+}
+
+static void*
+arenaRealloc( void* context, void* pointer, size_t oldSize, size_t newSize )
+{
+	WArena* arena = context;
+
+	//Grow or shrink the most recent allocation in place if possible.
+	if ( (char*)pointer + arenaRound( oldSize ) == arena->next and arenaRound( newSize ) <= (size_t)(arena->end - (char*)pointer) ) {
+		arena->next = (char*)pointer + arenaRound( newSize );
+		return pointer;
+	}
+
+	void* newPointer = warena_alloc( arena, newSize );
+	memcpy( newPointer, pointer, oldSize < newSize ? oldSize : newSize );
+	return newPointer;
+}
+
+static void
+arenaFree( void* context, void* pointer )
+{
+	(void)context;
+	(void)pointer;
+}
+
+WArena*
+warena_new( const WAllocator* backing )
+{
+	if ( not backing ) backing = wallocatorDefault;
+
+	WArena* arena = wallocator_alloc( backing, sizeof( WArena ));
+	*arena = (WArena){
+		.allocator = { .alloc = arenaAlloc, .realloc = arenaRealloc, .free = arenaFree, .context = arena },
+		.backing = backing,
+	};
+
+	assert( arena );
+	return arena;
+}
+
+void
+warena_delete( WArena** arenaPtr )
+{
+	if ( not arenaPtr or not *arenaPtr ) return;
+
+	WArena* arena = *arenaPtr;
+	warena_reset( arena );
+	wallocator_free( arena->backing, arena->chunk );
+	wallocator_free( arena->backing, arena );
+	*arenaPtr = NULL;
+}
+
+void*
+warena_alloc( WArena* arena, size_t size )
+{
+	assert( arena );
+	assert( size > 0 );
+
+	size = arenaRound( size );
+
+	if ( size > (size_t)(arena->end - arena->next) ) {	//Start a new chunk.
+		size_t chunkSize = arena->chunk ? __wmax( arena->chunk->size * 2, (size_t)ArenaMinChunkSize ) : ArenaMinChunkSize;
+		if ( chunkSize > ArenaMaxChunkSize ) chunkSize = ArenaMaxChunkSize;
+		chunkSize = __wmax( chunkSize, size );
+
+		ArenaChunk* chunk = wallocator_alloc( arena->backing, sizeof( ArenaChunk ) + chunkSize );
+		chunk->previous = arena->chunk;
+		chunk->size = chunkSize;
+		arena->chunk = chunk;
+		arena->next = (char*)chunk->data;
+		arena->end = arena->next + chunkSize;
+	}
+
+	void* pointer = arena->next;
+	arena->next += size;
+
+	assert( pointer );
+	assert( arena->next <= arena->end );
+	return pointer;
+}
+
+void
+warena_reset( WArena* arena )
+{
+	assert( arena );
+
+	if ( not arena->chunk ) return;
+
+	//Keep the most recent and thus biggest chunk.
+	ArenaChunk* chunk = arena->chunk->previous;
+	while ( chunk ) {
+		ArenaChunk* previous = chunk->previous;
+		wallocator_free( arena->backing, chunk );
+		chunk = previous;
+	}
+
+	arena->chunk->previous = NULL;
+	arena->next = (char*)arena->chunk->data;
+	arena->end = arena->next + arena->chunk->size;
+}
+
+const WAllocator*
+warena_allocator( const WArena* arena )
+{
+	assert( arena );
+	return &arena->allocator;
+}
+
+//---------------------------------------------------------------------------------
+
+void*
+__wxmalloc( size_t size )
+{
+	return wallocator_alloc( wallocatorDefault, size );
+}
+
+void*
+__wxrealloc( void* pointer, size_t size )
+{
+	return wallocator_realloc( wallocatorDefault, pointer, 0, size );	//The default allocator needs no old size.
+}
+
 static int
 __wxvsnprintf( char* string, size_t size, const char* format, va_list args )
 {
@@ -100,6 +309,459 @@ __wstr_dup( const char* string )
     return copy;
 }
 
+//---------------------------------------------------------------------------------
+//	String buffers
+//---------------------------------------------------------------------------------
+
+enum StrBufParameters {
+	StrBufDefaultCapacity	= 64,
+	StrBufGrowthRate		= 2,
+};
+
+WStrBuf*
+wstrbuf_new( size_t capacity )
+{
+	if ( not capacity ) capacity = StrBufDefaultCapacity;
+
+	WStrBuf* buf = __wxnew( WStrBuf, .string = __wxmalloc( capacity ), .capacity = capacity );
+	buf->string[0] = '\0';
+
+	assert( buf );
+	return buf;
+}
+
+void
+wstrbuf_delete( WStrBuf** buf )
+{
+	if ( not buf or not *buf ) return;
+
+	free( (*buf)->string );
+	free( *buf );
+	*buf = NULL;
+}
+
+WStrBuf*
+wstrbuf_reserve( WStrBuf* buf, size_t size )
+{
+	assert( buf );
+
+	size_t needed = buf->size + size + 1;
+	if ( needed > buf->capacity ) {
+		buf->capacity = __wmax( needed, buf->capacity * StrBufGrowthRate );
+		buf->string = __wxrealloc( buf->string, buf->capacity );
+	}
+
+	assert( buf->capacity > buf->size + size );
+	return buf;
+}
+
+WStrBuf*
+wstrbuf_append( WStrBuf* buf, const char* string )
+{
+	assert( string );
+	return wstrbuf_appendn( buf, string, strlen( string ));
+}
+
+WStrBuf*
+wstrbuf_appendn( WStrBuf* buf, const char* string, size_t length )
+{
+	assert( buf );
+	assert( string );
+
+	wstrbuf_reserve( buf, length );
+	memcpy( buf->string + buf->size, string, length );
+	buf->size += length;
+	buf->string[buf->size] = '\0';
+
+	return buf;
+}
+
+WStrBuf*
+wstrbuf_printf( WStrBuf* buf, const char* format, ... )
+{
+	assert( buf );
+	assert( format );
+
+	va_list args, args_copy;
+	va_start( args, format );
+	va_copy( args_copy, args );
+
+	//Try to print into the free space first, most texts fit.
+	size_t space = buf->capacity - buf->size;
+	size_t len = __wxvsnprintf( buf->string + buf->size, space, format, args );
+	if ( len >= space ) {
+		wstrbuf_reserve( buf, len );
+		__wxvsnprintf( buf->string + buf->size, len + 1, format, args_copy );
+	}
+	buf->size += len;
+
+	va_end( args_copy );
+	va_end( args );
+
+	assert( buf->string[buf->size] == '\0' );
+	return buf;
+}
+
+WStrBuf*
+wstrbuf_clear( WStrBuf* buf )
+{
+	assert( buf );
+
+	buf->size = 0;
+	buf->string[0] = '\0';
+
+	return buf;
+}
+
+char*
+wstrbuf_steal( WStrBuf** buf )
+{
+	assert( buf and *buf );
+
+	char* string = (*buf)->string;
+	free( *buf );
+	*buf = NULL;
+
+	assert( string );
+	return string;
+}
+
+//---------------------------------------------------------------------------------
+//	Thread pools
+//---------------------------------------------------------------------------------
+
+//Number of processors online, 1 if unknown.
+static size_t
+processorCount( void )
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long processors = sysconf( _SC_NPROCESSORS_ONLN );
+	if ( processors > 0 ) return processors;
+#endif
+	return 1;
+}
+
+#ifndef __STDC_NO_THREADS__
+
+enum PoolParameters {
+	PoolDequeCapacity	= 64,
+	PoolGrowthRate		= 2,
+};
+
+//A task of a wpool_run() call, which counts down the tasks of the call still pending.
+typedef struct PoolJob {
+	WTask*			task;
+	void*			taskData;
+	atomic_size_t*	pending;
+}PoolJob;
+
+//A ring buffer of jobs. The owner pushes and pops at the tail, thieves steal at the head.
+typedef struct PoolDeque {
+	mtx_t		lock;
+	PoolJob*	jobs;
+	size_t		head;
+	size_t		size;
+	size_t		capacity;
+}PoolDeque;
+
+typedef struct PoolWorker {
+	WPool*		pool;
+	size_t		number;
+	thrd_t		thread;
+}PoolWorker;
+
+struct WPool {
+	size_t			workers;
+	bool			pinned;
+	PoolWorker*		worker;
+	PoolDeque*		deques;		//One per worker
+	atomic_size_t	queued;		//Jobs in all deques
+	atomic_size_t	next;		//Round robin deque for jobs from other threads
+	mtx_t			sleep;		//Guards the waiting for wake and done
+	cnd_t			wake;		//Signaled when jobs were queued or the pool stops
+	cnd_t			done;		//Signaled when the last job of a wpool_run() call is done
+	bool			stop;
+};
+
+//The pool and worker number of the current thread, if it is a worker.
+static _Thread_local WPool* currentPool;
+static _Thread_local size_t currentWorker;
+
+static void
+pushJob( WPool* pool, size_t number, PoolJob job )
+{
+	PoolDeque* deque = &pool->deques[number];
+	mtx_lock( &deque->lock );
+	if ( deque->size == deque->capacity ) {		//Grow and unwrap the ring buffer.
+		size_t capacity = deque->capacity * PoolGrowthRate;
+		PoolJob* jobs = __wxmalloc( capacity * sizeof( PoolJob ));
+		for ( size_t i = 0; i < deque->size; i++ )
+			jobs[i] = deque->jobs[(deque->head + i) % deque->capacity];
+		free( deque->jobs );
+		deque->jobs = jobs;
+		deque->head = 0;
+		deque->capacity = capacity;
+	}
+	deque->jobs[(deque->head + deque->size++) % deque->capacity] = job;
+	atomic_fetch_add( &pool->queued, 1 );
+	mtx_unlock( &deque->lock );
+}
+
+//Pop the newest job of the deque or steal its oldest one.
+static bool
+popJob( WPool* pool, size_t number, bool steal, PoolJob* job )
+{
+	PoolDeque* deque = &pool->deques[number];
+	mtx_lock( &deque->lock );
+	bool found = deque->size > 0;
+	if ( found ) {
+		if ( steal ) {
+			*job = deque->jobs[deque->head];
+			deque->head = (deque->head + 1) % deque->capacity;
+		}
+		else
+			*job = deque->jobs[(deque->head + deque->size-1) % deque->capacity];
+		deque->size--;
+		atomic_fetch_sub( &pool->queued, 1 );
+	}
+	mtx_unlock( &deque->lock );
+	return found;
+}
+
+//Take a job from the own deque, if the thread is a worker, or steal one from the others.
+static bool
+takeJob( WPool* pool, PoolJob* job )
+{
+	bool worker = currentPool == pool;
+	size_t self = worker ? currentWorker : 0;
+	if ( worker and popJob( pool, self, false, job ))
+		return true;
+
+	for ( size_t i = worker; i < pool->workers; i++ )
+		if ( popJob( pool, (self + i) % pool->workers, true, job ))
+			return true;
+	return false;
+}
+
+static void
+runJob( WPool* pool, PoolJob* job )
+{
+	job->task( job->taskData );
+	if ( atomic_fetch_sub( job->pending, 1 ) == 1 ) {
+		mtx_lock( &pool->sleep );
+		cnd_broadcast( &pool->done );
+		mtx_unlock( &pool->sleep );
+	}
+}
+
+//Bind the calling thread to the processor with the number, where supported.
+static void
+pinThread( size_t number )
+{
+#if defined( __linux__ ) and defined( CPU_SET )
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	CPU_SET( number % processorCount(), &set );
+	sched_setaffinity( 0, sizeof( set ), &set );
+#else
+	(void)number;
+#endif
+}
+
+static int
+poolWorker( void* argument )
+{
+	PoolWorker* worker = argument;
+	WPool* pool = worker->pool;
+	currentPool = pool;
+	currentWorker = worker->number;
+	if ( pool->pinned ) pinThread( worker->number+1 );	//The first processor is left to the main thread.
+
+	while ( true ) {
+		PoolJob job;
+		if ( takeJob( pool, &job )) {
+			runJob( pool, &job );
+			continue;
+		}
+
+		mtx_lock( &pool->sleep );
+		while ( not atomic_load( &pool->queued ) and not pool->stop )
+			cnd_wait( &pool->wake, &pool->sleep );
+		bool stop = pool->stop and not atomic_load( &pool->queued );
+		mtx_unlock( &pool->sleep );
+		if ( stop ) break;
+	}
+	return 0;
+}
+
+WPool*
+wpool_new( size_t threads, bool pinned )
+{
+	if ( not threads ) threads = processorCount();
+
+	WPool* pool = __wxnew( WPool, .workers = threads-1, .pinned = pinned );
+	atomic_init( &pool->queued, 0 );
+	atomic_init( &pool->next, 0 );
+	mtx_init( &pool->sleep, mtx_plain );
+	cnd_init( &pool->wake );
+	cnd_init( &pool->done );
+
+	if ( pool->workers ) {		//A single thread pool runs everything in the calling thread.
+		pool->deques = __wxmalloc( pool->workers * sizeof( PoolDeque ));
+		pool->worker = __wxmalloc( pool->workers * sizeof( PoolWorker ));
+	}
+	for ( size_t i = 0; i < pool->workers; i++ ) {
+		pool->deques[i] = (PoolDeque){ .jobs = __wxmalloc( PoolDequeCapacity * sizeof( PoolJob )), .capacity = PoolDequeCapacity };
+		mtx_init( &pool->deques[i].lock, mtx_plain );
+	}
+	for ( size_t i = 0; i < pool->workers; i++ ) {
+		pool->worker[i] = (PoolWorker){ .pool = pool, .number = i };
+		if ( thrd_create( &pool->worker[i].thread, poolWorker, &pool->worker[i] ) != thrd_success )
+			__wdie( "Could not start a pool thread." );
+	}
+
+	assert( pool );
+	return pool;
+}
+
+void
+wpool_delete( WPool** poolPtr )
+{
+	if ( not poolPtr or not *poolPtr ) return;
+	WPool* pool = *poolPtr;
+
+	mtx_lock( &pool->sleep );
+	pool->stop = true;
+	cnd_broadcast( &pool->wake );
+	mtx_unlock( &pool->sleep );
+
+	for ( size_t i = 0; i < pool->workers; i++ ) {
+		thrd_join( pool->worker[i].thread, NULL );
+		mtx_destroy( &pool->deques[i].lock );
+		free( pool->deques[i].jobs );
+	}
+	cnd_destroy( &pool->done );
+	cnd_destroy( &pool->wake );
+	mtx_destroy( &pool->sleep );
+	free( pool->worker );
+	free( pool->deques );
+	free( pool );
+	*poolPtr = NULL;
+}
+
+size_t
+wpool_threads( const WPool* pool )
+{
+	assert( pool );
+	return pool->workers+1;
+}
+
+void
+wpool_run( WPool* pool, WTask* task, void* data, size_t count, size_t size )
+{
+	assert( pool );
+	assert( task );
+	assert( data or not count );
+
+	if ( not pool->workers or count < 2 ) {
+		for ( size_t i = 0; i < count; i++ )
+			task( (char*)data + i*size );
+		return;
+	}
+
+	//Workers put the jobs in their own deque, other threads spread them over all deques.
+	atomic_size_t pending;
+	atomic_init( &pending, count );
+	for ( size_t i = 0; i < count; i++ ) {
+		size_t number = currentPool == pool ? currentWorker : atomic_fetch_add( &pool->next, 1 ) % pool->workers;
+		pushJob( pool, number, (PoolJob){ task, (char*)data + i*size, &pending });
+	}
+	mtx_lock( &pool->sleep );
+	cnd_broadcast( &pool->wake );
+	cnd_broadcast( &pool->done );	//Threads waiting in wpool_run() may help out as well.
+	mtx_unlock( &pool->sleep );
+
+	//Help out until the own jobs are done.
+	while ( atomic_load( &pending )) {
+		PoolJob job;
+		if ( takeJob( pool, &job )) {
+			runJob( pool, &job );
+			continue;
+		}
+
+		mtx_lock( &pool->sleep );
+		while ( atomic_load( &pending ) and not atomic_load( &pool->queued ))
+			cnd_wait( &pool->done, &pool->sleep );
+		mtx_unlock( &pool->sleep );
+	}
+}
+
+#else	//No C11 threads: every pool executes its tasks in the calling thread.
+
+struct WPool {
+	size_t workers;
+};
+
+WPool*
+wpool_new( size_t threads, bool pinned )
+{
+	(void)threads;
+	(void)pinned;
+	return __wxnew( WPool, .workers = 0 );
+}
+
+void
+wpool_delete( WPool** poolPtr )
+{
+	if ( not poolPtr or not *poolPtr ) return;
+
+	free( *poolPtr );
+	*poolPtr = NULL;
+}
+
+size_t
+wpool_threads( const WPool* pool )
+{
+	assert( pool );
+	return 1;
+}
+
+void
+wpool_run( WPool* pool, WTask* task, void* data, size_t count, size_t size )
+{
+	assert( pool );
+	assert( task );
+	assert( data or not count );
+
+	for ( size_t i = 0; i < count; i++ )
+		task( (char*)data + i*size );
+}
+
+#endif
+
+static WPool* defaultPool;
+
+#ifndef __STDC_NO_THREADS__
+static once_flag defaultPoolOnce = ONCE_FLAG_INIT;
+#endif
+
+static void
+newDefaultPool( void )
+{
+	defaultPool = wpool_new( 0, false );
+}
+
+WPool*
+wpool_default( void )
+{
+#ifndef __STDC_NO_THREADS__
+	call_once( &defaultPoolOnce, newDefaultPool );
+#else
+	if ( not defaultPool ) newDefaultPool();
+#endif
+	return defaultPool;
+}
+
 //---------------------------------------------------------------------------------
 
 static char welementNotFound;
@@ -118,13 +780,30 @@ void wtypePtr_delete( void** wtypePtr ) {
 }
 
 int wtypePtr_compare( const void* e1, const void* e2 ) {
-	return (long)e1 - (long)e2;
+	return ((long)e1 > (long)e2) - ((long)e1 < (long)e2);	//A difference doesn't fit in int.
+}
+
+//Finalizer of MurmurHash3, spreading the bits over the whole hash value.
+static inline size_t
+mixBits( uint64_t x )
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return (size_t)x;
+}
+
+size_t wtypePtr_hash( const void* element ) {
+	return mixBits( (uintptr_t)element );
 }
 
 const WType* wtypePtr = &(WType) {
 	.clone = wtypePtr_clone,
 	.delete = wtypePtr_delete,
 	.compare = wtypePtr_compare,
+	.hash = wtypePtr_hash
 };
 
 //---------------------------------------------------------------------------------
@@ -140,7 +819,7 @@ void wtypeInt_delete( void** wtypePtr ) {
 }
 
 int wtypeInt_compare( const void* e1, const void* e2 ) {
-	return (long)e1 - (long)e2;
+	return ((long)e1 > (long)e2) - ((long)e1 < (long)e2);	//A difference could overflow int.
 }
 
 void* wtypeInt_fromString( const char* string ) {
@@ -154,12 +833,22 @@ char* wtypeInt_toString( const void* element ) {
     return __wstr_printf( "%ld", (long)element );
 }
 
+size_t wtypeInt_hash( const void* element ) {
+	return wtypePtr_hash( element );
+}
+
+void wtypeInt_toStrBuf( const void* element, WStrBuf* buf ) {
+	wstrbuf_printf( buf, "%ld", (long)element );
+}
+
 const WType* wtypeInt = &(WType) {
 	.clone = wtypeInt_clone,
 	.delete = wtypeInt_delete,
 	.compare = wtypeInt_compare,
 	.fromString = wtypeInt_fromString,
-	.toString = wtypeInt_toString
+	.toString = wtypeInt_toString,
+	.hash = wtypeInt_hash,
+	.toStrBuf = wtypeInt_toStrBuf
 };
 
 //---------------------------------------------------------------------------------
@@ -190,12 +879,58 @@ char* wtypeStr_toString( const void* element ) {
 	return __wstr_dup( element );
 }
 
+void* wtypeStr_cloneWith( const void* element, const WAllocator* allocator ) {
+	assert( element );
+
+	size_t size = strlen( element ) + 1;
+	return memcpy( wallocator_alloc( allocator, size ), element, size );
+}
+
+void wtypeStr_deleteWith( void** wtypePtr, const WAllocator* allocator ) {
+	wallocator_free( allocator, *wtypePtr );
+	*wtypePtr = NULL;
+}
+
+//64 bit FNV-1a hash.
+size_t wtypeStr_hash( const void* element ) {
+	if ( not element ) return 0;
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for ( const unsigned char* c = element; *c; c++ ) {
+		hash ^= *c;
+		hash *= 0x100000001b3ULL;
+	}
+	return (size_t)hash;
+}
+
+void wtypeStr_toStrBuf( const void* element, WStrBuf* buf ) {
+	assert( element );
+	wstrbuf_append( buf, element );
+}
+
 const WType* wtypeStr = &(WType) {
 	.clone = wtypeStr_clone,
 	.delete = wtype_delete,
 	.compare = wtypeStr_compare,
 	.fromString = wtypeStr_fromString,
-	.toString = wtypeStr_toString
+	.toString = wtypeStr_toString,
+	.cloneWith = wtypeStr_cloneWith,
+	.deleteWith = wtypeStr_deleteWith,
+	.hash = wtypeStr_hash,
+	.toStrBuf = wtypeStr_toStrBuf
+};
+
+const WType* wtypeStrArena = &(WType) {
+	.clone = wtypeStr_clone,
+	.delete = wtype_delete,
+	.compare = wtypeStr_compare,
+	.fromString = wtypeStr_fromString,
+	.toString = wtypeStr_toString,
+	.cloneWith = wtypeStr_cloneWith,
+	.deleteWith = wtypeStr_deleteWith,
+	.arena = true,
+	.hash = wtypeStr_hash,
+	.toStrBuf = wtypeStr_toStrBuf
 };
 
 //---------------------------------------------------------------------------------
@@ -209,7 +944,7 @@ void* wtypeDouble_clone( const void* element ) {
 }
 
 int wtypeDouble_compare( const void* e1, const void* e2 ) {
-	return (e1 and e2) ? *(double*)e1 - *(double*)e2 :
+	return (e1 and e2) ? (*(double*)e1 > *(double*)e2) - (*(double*)e1 < *(double*)e2) :
 			not e1 and not e2 ? 0 :
 			e1 ? +1 : -1;	//NULL values are considered to be less than every double value
 }
@@ -227,12 +962,43 @@ char* wtypeDouble_toString( const void* element ) {
     return __wstr_printf( "%lf", *(double*)element );
 }
 
+size_t wtypeDouble_hash( const void* element ) {
+	if ( not element ) return 0;
+
+	double value = *(double*)element;
+	if ( value == 0 ) value = 0;	//-0.0 equals 0.0
+
+	uint64_t bits;
+	memcpy( &bits, &value, sizeof( bits ));
+	return mixBits( bits );
+}
+
+void wtypeDouble_toStrBuf( const void* element, WStrBuf* buf ) {
+    assert( element );
+	wstrbuf_printf( buf, "%lf", *(double*)element );
+}
+
+void* wtypeDouble_cloneWith( const void* element, const WAllocator* allocator ) {
+	double* clone = wallocator_alloc( allocator, sizeof( double ));
+	*clone = *(double*)element;
+	return clone;
+}
+
+void wtypeDouble_deleteWith( void** wtypePtr, const WAllocator* allocator ) {
+	wallocator_free( allocator, *wtypePtr );
+	*wtypePtr = NULL;
+}
+
 const WType* wtypeDouble = &(WType) {
 	.clone = wtypeDouble_clone,
 	.delete = wtype_delete,
 	.compare = wtypeDouble_compare,
 	.fromString = wtypeDouble_fromString,
-	.toString = wtypeDouble_toString
+	.toString = wtypeDouble_toString,
+	.cloneWith = wtypeDouble_cloneWith,
+	.deleteWith = wtypeDouble_deleteWith,
+	.hash = wtypeDouble_hash,
+	.toStrBuf = wtypeDouble_toStrBuf
 };
 
 //---------------------------------------------------------------------------------
@@ -244,6 +1010,14 @@ bool wtypeStr_conditionEquals( const void* e1, const void* e2 ) {
 	return e1 == e2;
 }
 
+bool wtypePtr_conditionEquals( const void* e1, const void* e2 ) {
+	return e1 == e2;
+}
+
+bool wtypeInt_conditionEquals( const void* e1, const void* e2 ) {
+	return e1 == e2;
+}
+
 bool wtypeStr_conditionEmpty( const void* element, const void* conditionData ) {
 	(void)conditionData;
 	if ( element ) return ((char*)element)[0] == 0;
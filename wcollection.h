@@ -31,6 +31,258 @@
 */
 extern void* WElementNotFound;
 
+//---------------------------------------------------------------------------------
+//	Memory allocators
+//---------------------------------------------------------------------------------
+
+/**	Function prototype for allocating memory.
+
+	@param context The allocator's context, e.g. a pool or an arena. May be NULL.
+	@param size The number of bytes. Is never 0.
+	@return The allocated memory or NULL if out of memory.
+*/
+typedef void*	WAllocatorAlloc(void* context, size_t size);
+
+/**	Function prototype for resizing allocated memory.
+
+	@param context The allocator's context. May be NULL.
+	@param pointer Memory allocated with the same allocator. Is never NULL.
+	@param oldSize The current size of the memory block. Allocators not needing it may ignore it.
+	@param newSize The new size of the memory block. Is never 0.
+	@return The resized memory or NULL if out of memory.
+*/
+typedef void*	WAllocatorRealloc(void* context, void* pointer, size_t oldSize, size_t newSize);
+
+/**	Function prototype for freeing allocated memory.
+
+	@param context The allocator's context. May be NULL.
+	@param pointer Memory allocated with the same allocator. May be NULL.
+*/
+typedef void	WAllocatorFree(void* context, void* pointer);
+
+/**	Defines where a collection gets its memory from. It can be passed e.g. to
+	warray_newWithAllocator(), so arenas, pools or other malloc() replacements can
+	be plugged in per collection.
+*/
+typedef struct WAllocator {
+	WAllocatorAlloc*	alloc;		///<Method to allocate memory. Mandatory.
+	WAllocatorRealloc*	realloc;	///<Method to resize memory. Mandatory.
+	WAllocatorFree*		free;		///<Method to free memory. Mandatory.
+	void*				context;	///<Passed to the methods above. May be NULL.
+}WAllocator;
+
+/**	The allocator using malloc(), realloc() and free(). It is used by default and by
+	all element methods without an allocator argument.
+*/
+extern const WAllocator* wallocatorDefault;
+
+/**	Allocate memory with the given allocator and abort the program if out of memory.
+*/
+void*
+wallocator_alloc( const WAllocator* allocator, size_t size );
+
+/**	Resize memory with the given allocator and abort the program if out of memory.
+*/
+void*
+wallocator_realloc( const WAllocator* allocator, void* pointer, size_t oldSize, size_t newSize );
+
+/**	Free memory with the given allocator. If pointer is NULL, this is a no-op.
+*/
+void
+wallocator_free( const WAllocator* allocator, void* pointer );
+
+//---------------------------------------------------------------------------------
+//	Arenas
+//---------------------------------------------------------------------------------
+
+/**	A bump allocator handing out memory from big chunks. Single allocations can't be freed,
+	instead all memory is released at once by warena_reset() or warena_delete().
+*/
+typedef struct WArena WArena;
+
+/**	Create a new empty arena.
+
+	@param backing The allocator the arena takes its chunks from. If NULL is passed,
+		wallocatorDefault is used.
+	@return The new arena
+*/
+WArena*
+warena_new( const WAllocator* backing );
+
+/**	Free all chunks and the arena itself. If NULL is passed, this is a no-op.
+
+	@param arena Pointer to an arena. After the deletion the pointer is set to NULL.
+*/
+void
+warena_delete( WArena** arena );
+
+/**	Allocate memory aligned for any type from the arena.
+
+	@pre arena != NULL
+	@pre size > 0
+*/
+void*
+warena_alloc( WArena* arena, size_t size );
+
+/**	Release all memory allocated from the arena at once.
+
+	Only the most recent chunk is kept for further allocations, so the costs don't depend on
+	the number of allocations.
+
+	@pre arena != NULL
+*/
+void
+warena_reset( WArena* arena );
+
+/**	Return an allocator allocating from the arena. Its free() method is a no-op.
+
+	@pre arena != NULL
+*/
+const WAllocator*
+warena_allocator( const WArena* arena );
+
+//---------------------------------------------------------------------------------
+//	String buffers
+//---------------------------------------------------------------------------------
+
+/**	A growable string for building texts piece by piece in linear time.
+*/
+typedef struct WStrBuf {
+	char*	string;		///<Public read-only, the zero terminated text
+	size_t	size;		///<Public read-only, the text length without the terminating zero
+	size_t	capacity;	//Private, do not directly access it.
+}WStrBuf;
+
+/**	Create a new empty string buffer.
+
+	@param capacity The initial capacity in bytes. If 0 is given, a default capacity is used.
+	@return The new string buffer
+*/
+WStrBuf*
+wstrbuf_new( size_t capacity );
+
+/**	Free the string buffer and its text. If NULL is passed, this is a no-op.
+
+	@param buf Pointer to a string buffer. After the deletion the pointer is set to NULL.
+*/
+void
+wstrbuf_delete( WStrBuf** buf );
+
+/**	Make sure that size more characters can be appended without growing the buffer.
+
+	@pre buf != NULL
+*/
+WStrBuf*
+wstrbuf_reserve( WStrBuf* buf, size_t size );
+
+/**	Append a zero terminated string.
+
+	@pre buf != NULL
+	@pre string != NULL
+*/
+WStrBuf*
+wstrbuf_append( WStrBuf* buf, const char* string );
+
+/**	Append the first length characters of a string.
+
+	@pre buf != NULL
+	@pre string != NULL
+*/
+WStrBuf*
+wstrbuf_appendn( WStrBuf* buf, const char* string, size_t length );
+
+/**	Append a text formatted like printf() does.
+
+	@pre buf != NULL
+	@pre format != NULL
+*/
+WStrBuf*
+wstrbuf_printf( WStrBuf* buf, const char* format, ... );
+
+/**	Empty the text, but keep the memory for further use.
+
+	@pre buf != NULL
+*/
+WStrBuf*
+wstrbuf_clear( WStrBuf* buf );
+
+/**	Take over the text and free the rest of the string buffer.
+
+	@param buf Pointer to a string buffer. Afterwards the pointer is set to NULL.
+	@return The text, which must be freed with free() by the caller.
+	@pre buf != NULL and *buf != NULL
+*/
+char*
+wstrbuf_steal( WStrBuf** buf );
+
+//---------------------------------------------------------------------------------
+//	Thread pools
+//---------------------------------------------------------------------------------
+
+/**	A fixed set of worker threads executing tasks for parallel collection operations. Every
+	worker has its own deque of tasks: it takes the newest task of its own deque first and
+	steals the oldest tasks of the others when it runs dry. The thread waiting in wpool_run()
+	executes tasks as well, so nested parallel operations can't deadlock.
+*/
+typedef struct WPool WPool;
+
+/**	Function prototype for a task executed by a thread pool.
+
+	@param taskData The data of this task given to wpool_run().
+*/
+typedef void	WTask(void* taskData);
+
+/**	Create a new thread pool.
+
+	Without C11 thread support (__STDC_NO_THREADS__) the pool has no workers and executes all
+	tasks in the calling thread.
+
+	@param threads The number of threads executing tasks including the thread calling
+		wpool_run(), so threads-1 workers are started. If 0 is given, one per processor.
+	@param pinned Bind every worker to a processor of its own. Only supported on Linux,
+		elsewhere a no-op.
+	@return The new pool
+*/
+WPool*
+wpool_new( size_t threads, bool pinned );
+
+/**	Stop and join the workers and free the pool. Tasks still running are finished first.
+	If NULL is passed, this is a no-op.
+
+	@param poolPtr Pointer to a pool. After the deletion the pointer is set to NULL.
+	@pre No wpool_run() on this pool is in progress.
+*/
+void
+wpool_delete( WPool** poolPtr );
+
+/**	Return the pool shared by all parallel collection operations. It is created at the first
+	call with one thread per processor and lives until the program ends.
+*/
+WPool*
+wpool_default( void );
+
+/**	Return the number of threads executing tasks, including the one calling wpool_run().
+
+	@pre pool != NULL
+*/
+size_t
+wpool_threads( const WPool* pool );
+
+/**	Execute task( data + i*size ) for every i < count in the pool and wait until all tasks are
+	done. The calling thread executes tasks meanwhile. Tasks may call wpool_run() themselves.
+
+	@param pool
+	@param task
+	@param data An array of count task data items.
+	@param count The number of tasks.
+	@param size The byte size of a task data item.
+	@pre pool != NULL
+	@pre task != NULL
+	@pre data != NULL or count == 0
+*/
+void
+wpool_run( WPool* pool, WTask* task, void* data, size_t count, size_t size );
+
 //---------------------------------------------------------------------------------
 //	Function prototypes for the element methods
 //---------------------------------------------------------------------------------
@@ -52,6 +304,22 @@ typedef void*	WElementClone(const void* element);
 */
 typedef void	WElementDelete(void** elementPtr);
 
+/**	Function prototype for cloning an element with the collection's allocator.
+
+	@param element The element to be cloned. Is never NULL.
+	@param allocator The allocator of the target collection. Is never NULL.
+	@return Output element of the target collection. May be NULL.
+*/
+typedef void*	WElementCloneWith(const void* element, const WAllocator* allocator);
+
+/**	Function prototype for deleting an element cloned with a WElementCloneWith method.
+
+	@param elementPtr Pointer to the element to be deleted. elementPtr is never NULL. *elementPtr
+		may be NULL.
+	@param allocator The allocator the element was cloned with. Is never NULL.
+*/
+typedef void	WElementDeleteWith(void** elementPtr, const WAllocator* allocator);
+
 /**	Function prototype for comparing to elements with another.
 
 	@param element1 1st input element to be compared. May be NULL.
@@ -60,6 +328,15 @@ typedef void	WElementDelete(void** elementPtr);
 */
 typedef int		WElementCompare(const void* element1, const void* element2);
 
+/**	Function prototype for hashing an element.
+
+	Elements, which are equal according to the compare() method, must get the same hash value.
+
+	@param element Input element to be hashed. May be NULL.
+	@return The hash value
+*/
+typedef size_t	WElementHash(const void* element);
+
 /**	Function prototype for getting an element from a string.
 
 	@param string Input string to be converted to a collection element. Is never NULL.
@@ -74,6 +351,13 @@ typedef void*	WElementFromString(const char* string);
 */
 typedef char*	WElementToString(const void* element);
 
+/**	Function prototype for appending the text of an element to a string buffer.
+
+	@param element Input element of the source collection. Is never NULL.
+	@param buf The string buffer to append the text to. Is never NULL.
+*/
+typedef void	WElementToStrBuf(const void* element, WStrBuf* buf);
+
 /**	Function prototype for doing read-only stuff to an element.
 
 	@param element Input element of the source collection. May be NULL.
@@ -108,6 +392,24 @@ typedef void*	WElementMap(const void* element, const void* mapData);
 */
 typedef	void*	WElementReduce(const void* element, const void* intermediate);
 
+/**	Function prototype for combining two intermediate results of a reduction over consecutive
+	parts of a collection to the intermediate result of both parts.
+
+	@param intermediate1 The result of the first part. May be NULL.
+	@param intermediate2 The result of the following part. May be NULL.
+	@return The combined value, allocated according to the behaviour of the target type clone()
+		method. May be NULL.
+*/
+typedef	void*	WElementCombine(const void* intermediate1, const void* intermediate2);
+
+/**	Function prototype for folding an element into an accumulator, which is changed in place.
+
+	@param element Input element of the source collection. May be NULL.
+	@param accumulator The caller's accumulator, e.g. a counter or a WStrBuf.
+	@param foldData May be NULL.
+*/
+typedef	void	WElementFold(const void* element, void* accumulator, const void* foldData);
+
 /**	Function prototype returning true if the element meets a certaion condition.
 
 	@param element Input element of the source collection. May be NULL.
@@ -129,6 +431,11 @@ typedef struct WType {
 	WElementCompare*	compare;	///<Method to compare two elements with each other. Mandatory only for some collection functions.
 	WElementFromString*	fromString;	///<Method to parse an element from a string. Mandatory only for some collection functions.
 	WElementToString*	toString;	///<Method to convert an element to a string. Mandatory only for some collection functions.
+	WElementCloneWith*	cloneWith;	///<Method to copy an element with the collection's allocator. Optional, preferred to clone().
+	WElementDeleteWith*	deleteWith;	///<Method to destroy an element copied with cloneWith(). Mandatory if cloneWith is given.
+	bool				arena;		///<If true, the collection clones the elements with cloneWith() into its own arena and releases them all at once.
+	WElementHash*		hash;		///<Method to hash an element consistently with compare(). Optional, speeds up some collection functions.
+	WElementToStrBuf*	toStrBuf;	///<Method to append the element text to a string buffer. Optional, preferred to toString().
 }WType;
 
 //---------------------------------------------------------------------------------
@@ -142,6 +449,7 @@ typedef struct WType {
 	- compare = wtypePtr_compare()
 	- fromString = NULL
 	- toString = NULL
+	- hash = wtypePtr_hash()
 */
 extern const WType* wtypePtr;
 
@@ -152,6 +460,8 @@ extern const WType* wtypePtr;
 	- compare = wtypeInt_compare()
 	- fromString = wtypeInt_fromString()
 	- toString = wtypeInt_toString()
+	- hash = wtypeInt_hash()
+	- toStrBuf = wtypeInt_toStrBuf()
 */
 extern const WType* wtypeInt;
 
@@ -162,9 +472,33 @@ extern const WType* wtypeInt;
 	- compare = wtypeStr_compare()
 	- fromString = wtypeStr_fromString()
 	- toString = wtypeStr_toString()
+	- cloneWith = wtypeStr_cloneWith()
+	- deleteWith = wtypeStr_deleteWith()
+	- hash = wtypeStr_hash()
+	- toStrBuf = wtypeStr_toStrBuf()
 */
 extern const WType* wtypeStr;
 
+/** Defines a collection type for char* values, which are allocated in a per-collection arena.
+	Can be passed to functions like warray_new().
+
+	Compared to wtypeStr putting a string in a collection is a cheap bump allocation and
+	clearing or deleting the collection releases all strings at once instead of one by one.
+	Removing single strings doesn't free their memory until the collection is cleared.
+
+	- clone = wtypeStr_clone()
+	- delete = wtypeStr_delete()
+	- compare = wtypeStr_compare()
+	- fromString = wtypeStr_fromString()
+	- toString = wtypeStr_toString()
+	- cloneWith = wtypeStr_cloneWith()
+	- deleteWith = wtypeStr_deleteWith()
+	- arena = true
+	- hash = wtypeStr_hash()
+	- toStrBuf = wtypeStr_toStrBuf()
+*/
+extern const WType* wtypeStrArena;
+
 /** Defines a collection type for double values. Can be passed to functions like warray_new().
 
 	- clone = wtypeDouble_clone()
@@ -172,6 +506,10 @@ extern const WType* wtypeStr;
 	- compare = wtypeDouble_compare()
 	- fromString = wtypeDouble_fromString()
 	- toString = wtypeDouble_toString()
+	- cloneWith = wtypeDouble_cloneWith()
+	- deleteWith = wtypeDouble_deleteWith()
+	- hash = wtypeDouble_hash()
+	- toStrBuf = wtypeDouble_toStrBuf()
 */
 extern const WType* wtypeDouble;
 
@@ -199,6 +537,11 @@ wtypePtr_delete( void** element );
 int
 wtypePtr_compare( const void* element1, const void* element2 );
 
+/**	Hash the pointer value.
+*/
+size_t
+wtypePtr_hash( const void* element );
+
 //---------------------------------------------------------------------------------
 //	int element methods
 //---------------------------------------------------------------------------------
@@ -237,6 +580,16 @@ wtypeInt_fromString( const char* str );
 char*
 wtypeInt_toString( const void* element );
 
+/**	Hash the int value.
+*/
+size_t
+wtypeInt_hash( const void* element );
+
+/**	Append the int value as decimal number.
+*/
+void
+wtypeInt_toStrBuf( const void* element, WStrBuf* buf );
+
 //---------------------------------------------------------------------------------
 //	char* element methods
 //---------------------------------------------------------------------------------
@@ -264,6 +617,26 @@ wtypeStr_fromString( const char* str );
 char*
 wtypeStr_toString( const void* element );
 
+/**	Hash the string content, NULL elements get the hash value 0.
+*/
+size_t
+wtypeStr_hash( const void* element );
+
+/**	Append the string.
+*/
+void
+wtypeStr_toStrBuf( const void* element, WStrBuf* buf );
+
+/**	Clone a char* element with the given allocator.
+*/
+void*
+wtypeStr_cloneWith( const void* element, const WAllocator* allocator );
+
+/**	Free a char* element with the given allocator and set the pointer to NULL.
+*/
+void
+wtypeStr_deleteWith( void** element, const WAllocator* allocator );
+
 //---------------------------------------------------------------------------------
 //	double element methods
 //---------------------------------------------------------------------------------
@@ -287,6 +660,26 @@ wtypeDouble_fromString( const char* str );
 char*
 wtypeDouble_toString( const void* element );
 
+/**	Hash the double value, NULL elements get the hash value 0.
+*/
+size_t
+wtypeDouble_hash( const void* element );
+
+/**	Append the double value formatted like wtypeDouble_toString() does.
+*/
+void
+wtypeDouble_toStrBuf( const void* element, WStrBuf* buf );
+
+/**	Clone a double element with the given allocator.
+*/
+void*
+wtypeDouble_cloneWith( const void* element, const WAllocator* allocator );
+
+/**	Free a double element with the given allocator and set the pointer to NULL.
+*/
+void
+wtypeDouble_deleteWith( void** element, const WAllocator* allocator );
+
 //---------------------------------------------------------------------------------
 //	Other element methods
 //---------------------------------------------------------------------------------
@@ -303,6 +696,17 @@ wtype_delete( void** element );
 bool
 wtypeStr_conditionEquals( const void* element1, const void* element2 );
 
+/**	True if the pointer element equals the conditionData pointer. warray_count() counts with
+	vector instructions when passed this function.
+*/
+bool
+wtypePtr_conditionEquals( const void* element, const void* conditionData );
+
+/**	True if the int element equals the int conditionData, see wtypePtr_conditionEquals().
+*/
+bool
+wtypeInt_conditionEquals( const void* element, const void* conditionData );
+
 bool
 wtypeStr_conditionEmpty( const void* element, const void* conditionData );
 
@@ -324,11 +728,11 @@ wtypeStr_foreachIndexPrint( const void* element, size_t index, const void* forea
 void
 __wdie( const char* text );
 
-//Not part of the public API, do not use: malloc wrapper
+//Not part of the public API, do not use: malloc wrapper using wallocatorDefault
 void*
 __wxmalloc( size_t size );
 
-//Not part of the public API, do not use: realloc wrapper
+//Not part of the public API, do not use: realloc wrapper using wallocatorDefault
 void*
 __wxrealloc( void* pointer, size_t size );
 
@@ -347,6 +751,9 @@ __wstr_dup( const char* string );
 //Not part of the public API, do not use: max() macro
 #define __wmax( x, y )	((x) > (y) ? (x) : (y))
 
+//Not part of the public API, do not use: min() macro
+#define __wmin( x, y )	((x) < (y) ? (x) : (y))
+
 //Not part of the public API, do not use: swap() macro
 #define __wswapPtr( var1, var2 )\
 do {							\